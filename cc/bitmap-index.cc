@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+#include "acmacs-base/fmt.hh"
+#include "acmacs-base/read-file.hh"
+#include "acmacs-virus/bitmap-index.hh"
+
+// ----------------------------------------------------------------------
+// File layout (native byte order):
+//   magic (8 bytes), number of rows (uint64_t)
+//   subtypes, years: number of bitmaps (uint32_t), for each: value (uint16_t), bitmap
+//   hosts, locations, countries, continents: number of bitmaps (uint32_t), for each: length (uint32_t), string, bitmap
+//   bitmap: number of chunks (uint32_t), for each: key (uint16_t), number of rows (uint32_t),
+//           rows (uint16_t each) if there are at most max_array_size of them, bitset (uint64_t each) otherwise
+// ----------------------------------------------------------------------
+
+static constexpr std::string_view sMagic{"ACVNBIX1"};
+
+template <typename T> static inline void append_value(std::string& target, T value)
+{
+    target.append(reinterpret_cast<const char*>(&value), sizeof(value));
+
+} // append_value
+
+template <typename T> static inline T read_value(std::string_view source, size_t& pos)
+{
+    if ((pos + sizeof(T)) > source.size())
+        throw std::runtime_error{"bitmap_index_t: truncated data"};
+    T value;
+    std::memcpy(&value, source.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return value;
+
+} // read_value
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::row_bitmap_t::add(row_t row)
+{
+    const auto key = static_cast<uint16_t>(row >> 16);
+    const auto low = static_cast<uint16_t>(row & 0xFFFF);
+    if (chunks_.empty() || chunks_.back().key != key)
+        chunks_.push_back(chunk_t{.key = key});
+    auto& chunk = chunks_.back();
+    if (chunk.bits.empty()) {
+        chunk.array.push_back(low);
+        if (chunk.array.size() > max_array_size)
+            to_bits(chunk);
+    }
+    else
+        chunk.bits[low / 64] |= uint64_t{1} << (low % 64);
+    ++chunk.count;
+
+} // acmacs::virus::name::row_bitmap_t::add
+
+// ----------------------------------------------------------------------
+
+size_t acmacs::virus::name::row_bitmap_t::count() const noexcept
+{
+    size_t count{0};
+    for (const auto& chunk : chunks_)
+        count += chunk.count;
+    return count;
+
+} // acmacs::virus::name::row_bitmap_t::count
+
+// ----------------------------------------------------------------------
+
+bool acmacs::virus::name::row_bitmap_t::contains(row_t row) const noexcept
+{
+    const auto key = static_cast<uint16_t>(row >> 16);
+    const auto low = static_cast<uint16_t>(row & 0xFFFF);
+    const auto chunk = std::lower_bound(chunks_.begin(), chunks_.end(), key, [](const auto& ch, uint16_t k) { return ch.key < k; });
+    if (chunk == chunks_.end() || chunk->key != key)
+        return false;
+    if (chunk->bits.empty())
+        return std::binary_search(chunk->array.begin(), chunk->array.end(), low);
+    else
+        return (chunk->bits[low / 64] >> (low % 64)) & 1;
+
+} // acmacs::virus::name::row_bitmap_t::contains
+
+// ----------------------------------------------------------------------
+
+std::vector<acmacs::virus::name::row_bitmap_t::row_t> acmacs::virus::name::row_bitmap_t::rows() const
+{
+    std::vector<row_t> result;
+    result.reserve(count());
+    for_each([&result](row_t row) { result.push_back(row); });
+    return result;
+
+} // acmacs::virus::name::row_bitmap_t::rows
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::row_bitmap_t::to_bits(chunk_t& chunk)
+{
+    chunk.bits.assign(bitset_words, 0);
+    for (const auto low : chunk.array)
+        chunk.bits[low / 64] |= uint64_t{1} << (low % 64);
+    chunk.array = std::vector<uint16_t>{};
+
+} // acmacs::virus::name::row_bitmap_t::to_bits
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::row_bitmap_t::to_array(chunk_t& chunk)
+{
+    chunk.array.clear();
+    chunk.array.reserve(chunk.count);
+    for (size_t word_no = 0; word_no < chunk.bits.size(); ++word_no) {
+        for (auto word = chunk.bits[word_no]; word != 0; word &= word - 1)
+            chunk.array.push_back(static_cast<uint16_t>(word_no * 64 + static_cast<size_t>(std::countr_zero(word))));
+    }
+    chunk.bits = std::vector<uint64_t>{};
+
+} // acmacs::virus::name::row_bitmap_t::to_array
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::row_bitmap_t::chunk_t acmacs::virus::name::row_bitmap_t::combine(const chunk_t& lhs, const chunk_t& rhs, set_op op)
+{
+    chunk_t result{.key = lhs.key};
+    if (lhs.bits.empty() && (rhs.bits.empty() || op != set_op::union_)) {
+        // result is an array, unless union of arrays is too big
+        if (rhs.bits.empty()) {
+            switch (op) {
+                case set_op::intersection:
+                    std::set_intersection(lhs.array.begin(), lhs.array.end(), rhs.array.begin(), rhs.array.end(), std::back_inserter(result.array));
+                    break;
+                case set_op::union_:
+                    std::set_union(lhs.array.begin(), lhs.array.end(), rhs.array.begin(), rhs.array.end(), std::back_inserter(result.array));
+                    break;
+                case set_op::difference:
+                    std::set_difference(lhs.array.begin(), lhs.array.end(), rhs.array.begin(), rhs.array.end(), std::back_inserter(result.array));
+                    break;
+            }
+        }
+        else {
+            const auto in_rhs = [&rhs, keep = op == set_op::intersection](uint16_t low) { return static_cast<bool>((rhs.bits[low / 64] >> (low % 64)) & 1) == keep; };
+            std::copy_if(lhs.array.begin(), lhs.array.end(), std::back_inserter(result.array), in_rhs);
+        }
+        result.count = static_cast<uint32_t>(result.array.size());
+        if (result.count > max_array_size)
+            to_bits(result);
+        return result;
+    }
+
+    const auto bits_of = [](const chunk_t& chunk) {
+        if (!chunk.bits.empty())
+            return chunk.bits;
+        chunk_t copy{.array = chunk.array};
+        to_bits(copy);
+        return copy.bits;
+    };
+    result.bits = bits_of(lhs);
+    const auto rhs_bits = bits_of(rhs);
+    for (size_t word_no = 0; word_no < bitset_words; ++word_no) {
+        switch (op) {
+            case set_op::intersection:
+                result.bits[word_no] &= rhs_bits[word_no];
+                break;
+            case set_op::union_:
+                result.bits[word_no] |= rhs_bits[word_no];
+                break;
+            case set_op::difference:
+                result.bits[word_no] &= ~rhs_bits[word_no];
+                break;
+        }
+        result.count += static_cast<uint32_t>(std::popcount(result.bits[word_no]));
+    }
+    if (result.count <= max_array_size)
+        to_array(result);
+    return result;
+
+} // acmacs::virus::name::row_bitmap_t::combine
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::row_bitmap_t::combine(const row_bitmap_t& rhs, set_op op)
+{
+    const bool keep_lhs_only = op != set_op::intersection, keep_rhs_only = op == set_op::union_;
+    std::vector<chunk_t> result;
+    auto lhs_chunk = chunks_.begin();
+    auto rhs_chunk = rhs.chunks_.begin();
+    while (lhs_chunk != chunks_.end() || rhs_chunk != rhs.chunks_.end()) {
+        if (rhs_chunk == rhs.chunks_.end() || (lhs_chunk != chunks_.end() && lhs_chunk->key < rhs_chunk->key)) {
+            if (keep_lhs_only)
+                result.push_back(std::move(*lhs_chunk));
+            ++lhs_chunk;
+        }
+        else if (lhs_chunk == chunks_.end() || rhs_chunk->key < lhs_chunk->key) {
+            if (keep_rhs_only)
+                result.push_back(*rhs_chunk);
+            ++rhs_chunk;
+        }
+        else {
+            if (auto combined = combine(*lhs_chunk, *rhs_chunk, op); combined.count != 0)
+                result.push_back(std::move(combined));
+            ++lhs_chunk;
+            ++rhs_chunk;
+        }
+    }
+    chunks_ = std::move(result);
+
+} // acmacs::virus::name::row_bitmap_t::combine
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::row_bitmap_t& acmacs::virus::name::row_bitmap_t::operator&=(const row_bitmap_t& rhs)
+{
+    combine(rhs, set_op::intersection);
+    return *this;
+
+} // acmacs::virus::name::row_bitmap_t::operator&=
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::row_bitmap_t& acmacs::virus::name::row_bitmap_t::operator|=(const row_bitmap_t& rhs)
+{
+    combine(rhs, set_op::union_);
+    return *this;
+
+} // acmacs::virus::name::row_bitmap_t::operator|=
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::row_bitmap_t& acmacs::virus::name::row_bitmap_t::operator-=(const row_bitmap_t& rhs)
+{
+    combine(rhs, set_op::difference);
+    return *this;
+
+} // acmacs::virus::name::row_bitmap_t::operator-=
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::row_bitmap_t::write(std::string& target) const
+{
+    append_value(target, static_cast<uint32_t>(chunks_.size()));
+    for (const auto& chunk : chunks_) {
+        append_value(target, chunk.key);
+        append_value(target, chunk.count);
+        if (chunk.bits.empty())
+            target.append(reinterpret_cast<const char*>(chunk.array.data()), chunk.array.size() * sizeof(uint16_t));
+        else
+            target.append(reinterpret_cast<const char*>(chunk.bits.data()), chunk.bits.size() * sizeof(uint64_t));
+    }
+
+} // acmacs::virus::name::row_bitmap_t::write
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::row_bitmap_t acmacs::virus::name::row_bitmap_t::read(std::string_view source, size_t& pos)
+{
+    row_bitmap_t bitmap;
+    bitmap.chunks_.resize(read_value<uint32_t>(source, pos));
+    for (auto& chunk : bitmap.chunks_) {
+        chunk.key = read_value<uint16_t>(source, pos);
+        chunk.count = read_value<uint32_t>(source, pos);
+        if (chunk.count == 0 || chunk.count > 65536)
+            throw std::runtime_error{"bitmap_index_t: invalid data"};
+        if (chunk.count <= max_array_size) {
+            chunk.array.resize(chunk.count);
+            for (auto& low : chunk.array)
+                low = read_value<uint16_t>(source, pos);
+        }
+        else {
+            chunk.bits.resize(bitset_words);
+            for (auto& word : chunk.bits)
+                word = read_value<uint64_t>(source, pos);
+        }
+    }
+    return bitmap;
+
+} // acmacs::virus::name::row_bitmap_t::read
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::bitmap_index_t::add(const parsed_columns_t& columns)
+{
+    if ((size_ + columns.size()) > std::numeric_limits<row_t>::max())
+        throw std::invalid_argument{fmt::format("bitmap_index_t: too many rows: {}", size_ + columns.size())};
+
+    // strings are looked up once per distinct id of the batch
+    using by_id_t = std::unordered_map<parsed_columns_t::id_t, row_bitmap_t*>;
+    const auto bitmap = [&columns](string_bitmaps_t& bitmaps, by_id_t& by_id, parsed_columns_t::id_t id) -> row_bitmap_t& {
+        auto [found, inserted] = by_id.emplace(id, nullptr);
+        if (inserted) {
+            const auto str = columns[id];
+            if (auto existing = bitmaps.find(str); existing != bitmaps.end())
+                found->second = &existing->second;
+            else
+                found->second = &bitmaps.emplace(std::string{str}, row_bitmap_t{}).first->second;
+        }
+        return *found->second;
+    };
+    by_id_t host, location, country, continent;
+    for (size_t row = 0; row < columns.size(); ++row) {
+        const auto index_row = static_cast<row_t>(size_ + row);
+        subtype_[columns.subtype[row]].add(index_row);
+        year_[columns.year[row]].add(index_row);
+        bitmap(host_, host, columns.host[row]).add(index_row);
+        bitmap(location_, location, columns.location[row]).add(index_row);
+        bitmap(country_, country, columns.country[row]).add(index_row);
+        bitmap(continent_, continent, columns.continent[row]).add(index_row);
+    }
+    size_ += columns.size();
+
+} // acmacs::virus::name::bitmap_index_t::add
+
+// ----------------------------------------------------------------------
+
+const acmacs::virus::name::row_bitmap_t& acmacs::virus::name::bitmap_index_t::not_found()
+{
+#include "acmacs-base/global-constructors-push.hh"
+    static const row_bitmap_t not_found;
+#include "acmacs-base/diagnostics-pop.hh"
+    return not_found;
+
+} // acmacs::virus::name::bitmap_index_t::not_found
+
+// ----------------------------------------------------------------------
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::row_bitmap_t acmacs::virus::name::bitmap_index_t::all() const
+{
+    row_bitmap_t result;
+    for (size_t row = 0; row < size_; ++row)
+        result.add(static_cast<row_t>(row));
+    return result;
+
+} // acmacs::virus::name::bitmap_index_t::all
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::row_bitmap_t acmacs::virus::name::bitmap_index_t::years(uint16_t first, uint16_t last) const
+{
+    row_bitmap_t result;
+    for (auto year = year_.lower_bound(first); year != year_.end() && year->first <= last; ++year)
+        result |= year->second;
+    return result;
+
+} // acmacs::virus::name::bitmap_index_t::years
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::bitmap_index_t::write(const std::string& filename) const
+{
+    std::string data{sMagic};
+    append_value(data, static_cast<uint64_t>(size_));
+    const auto write_values = [&data](const auto& bitmaps) {
+        append_value(data, static_cast<uint32_t>(bitmaps.size()));
+        for (const auto& [value, bitmap] : bitmaps) {
+            append_value(data, value);
+            bitmap.write(data);
+        }
+    };
+    const auto write_strings = [&data](const string_bitmaps_t& bitmaps) {
+        append_value(data, static_cast<uint32_t>(bitmaps.size()));
+        for (const auto& [str, bitmap] : bitmaps) {
+            append_value(data, static_cast<uint32_t>(str.size()));
+            data.append(str);
+            bitmap.write(data);
+        }
+    };
+    write_values(subtype_);
+    write_values(year_);
+    write_strings(host_);
+    write_strings(location_);
+    write_strings(country_);
+    write_strings(continent_);
+
+    std::ofstream output{filename, std::ios::binary | std::ios::trunc};
+    if (!output.write(data.data(), static_cast<std::streamsize>(data.size())))
+        throw std::runtime_error{fmt::format("bitmap_index_t: cannot write {}", filename)};
+
+} // acmacs::virus::name::bitmap_index_t::write
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::bitmap_index_t acmacs::virus::name::bitmap_index_t::read(const std::string& filename)
+{
+    const std::string data = acmacs::file::read(filename);
+    if (std::string_view{data}.substr(0, sMagic.size()) != sMagic)
+        throw std::runtime_error{fmt::format("bitmap_index_t: {}: invalid file", filename)};
+    size_t pos{sMagic.size()};
+
+    bitmap_index_t index;
+    index.size_ = read_value<uint64_t>(data, pos);
+    const auto read_values = [&data, &pos](auto& bitmaps) {
+        using value_t = typename std::decay_t<decltype(bitmaps)>::key_type;
+        for (auto number = read_value<uint32_t>(data, pos); number > 0; --number) {
+            const auto value = read_value<value_t>(data, pos);
+            bitmaps.emplace(value, row_bitmap_t::read(data, pos));
+        }
+    };
+    const auto read_strings = [&data, &pos](string_bitmaps_t& bitmaps) {
+        for (auto number = read_value<uint32_t>(data, pos); number > 0; --number) {
+            const auto length = read_value<uint32_t>(data, pos);
+            if ((pos + length) > data.size())
+                throw std::runtime_error{"bitmap_index_t: truncated data"};
+            std::string str{std::string_view{data}.substr(pos, length)};
+            pos += length;
+            bitmaps.emplace(std::move(str), row_bitmap_t::read(data, pos));
+        }
+    };
+    read_values(index.subtype_);
+    read_values(index.year_);
+    read_strings(index.host_);
+    read_strings(index.location_);
+    read_strings(index.country_);
+    read_strings(index.continent_);
+    return index;
+
+} // acmacs::virus::name::bitmap_index_t::read
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
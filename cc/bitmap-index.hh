@@ -0,0 +1,147 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <bit>
+
+#include "acmacs-virus/virus-name-columns.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    // Compressed set of row numbers. Rows are split into chunks of 65536 by
+    // the upper 16 bits, rows of a chunk are stored as a sorted array of the
+    // lower 16 bits if there are at most max_array_size of them and as a
+    // bitset otherwise.
+    class row_bitmap_t
+    {
+      public:
+        using row_t = uint32_t;
+
+        // rows must be added in increasing order
+        void add(row_t row);
+
+        bool empty() const noexcept { return chunks_.empty(); }
+        size_t count() const noexcept;
+        bool contains(row_t row) const noexcept;
+        std::vector<row_t> rows() const;
+
+        // calls func(row) in increasing order
+        template <typename F> void for_each(F&& func) const
+        {
+            for (const auto& chunk : chunks_) {
+                const row_t base = static_cast<row_t>(chunk.key) << 16;
+                if (chunk.bits.empty()) {
+                    for (const auto low : chunk.array)
+                        func(base | low);
+                }
+                else {
+                    for (size_t word_no = 0; word_no < chunk.bits.size(); ++word_no) {
+                        for (auto word = chunk.bits[word_no]; word != 0; word &= word - 1)
+                            func(base | static_cast<row_t>(word_no * 64 + static_cast<size_t>(std::countr_zero(word))));
+                    }
+                }
+            }
+        }
+
+        row_bitmap_t& operator&=(const row_bitmap_t& rhs);
+        row_bitmap_t& operator|=(const row_bitmap_t& rhs);
+        row_bitmap_t& operator-=(const row_bitmap_t& rhs); // difference
+        friend row_bitmap_t operator&(row_bitmap_t lhs, const row_bitmap_t& rhs) { return lhs &= rhs; }
+        friend row_bitmap_t operator|(row_bitmap_t lhs, const row_bitmap_t& rhs) { return lhs |= rhs; }
+        friend row_bitmap_t operator-(row_bitmap_t lhs, const row_bitmap_t& rhs) { return lhs -= rhs; }
+        bool operator==(const row_bitmap_t&) const = default;
+
+        void write(std::string& target) const;
+        static row_bitmap_t read(std::string_view source, size_t& pos); // throws std::runtime_error if source is truncated
+
+      private:
+        static constexpr const size_t max_array_size{4096};
+        static constexpr const size_t bitset_words{65536 / 64};
+
+        struct chunk_t
+        {
+            uint16_t key{0};
+            uint32_t count{0};
+            std::vector<uint16_t> array{}; // either array
+            std::vector<uint64_t> bits{};  // or bits (bitset_words) is used
+            bool operator==(const chunk_t&) const = default;
+        };
+
+        std::vector<chunk_t> chunks_{}; // sorted by key, chunks are not empty
+
+        enum class set_op { intersection, union_, difference };
+
+        void combine(const row_bitmap_t& rhs, set_op op);
+        static chunk_t combine(const chunk_t& lhs, const chunk_t& rhs, set_op op);
+        static void to_bits(chunk_t& chunk);
+        static void to_array(chunk_t& chunk);
+    };
+
+    // ----------------------------------------------------------------------
+
+    // Bitmaps of rows of parsed_columns_t per subtype, host, location,
+    // country, continent and year. Batches are added as names arrive, rows
+    // of each next batch follow the rows of the previous ones. Queries are
+    // set operations on the bitmaps, e.g. H3N2 from Europe with year
+    // 2019-2021 and non-human host:
+    //    (index.subtype("A(H3N2)") & index.continent("EUROPE") & index.years(2019, 2021)) - index.host("")
+    class bitmap_index_t
+    {
+      public:
+        using row_t = row_bitmap_t::row_t;
+
+        void add(const parsed_columns_t& columns);
+
+        size_t size() const noexcept { return size_; }
+        row_bitmap_t all() const;
+
+        // empty bitmap is returned for values not in the index, empty value
+        // selects rows with that field empty, e.g. host("") selects human viruses
+        const row_bitmap_t& subtype(subtype_code_t code) const { return find(subtype_, code); }
+        const row_bitmap_t& subtype(std::string_view type_subtype) const { return find(subtype_, subtype_code(type_subtype)); }
+        const row_bitmap_t& host(std::string_view host) const { return find(host_, host); }
+        const row_bitmap_t& location(std::string_view location) const { return find(location_, location); }
+        const row_bitmap_t& country(std::string_view country) const { return find(country_, country); }
+        const row_bitmap_t& continent(std::string_view continent) const { return find(continent_, continent); }
+        const row_bitmap_t& year(uint16_t year) const { return find(year_, year); } // 0 - no year
+        row_bitmap_t years(uint16_t first, uint16_t last) const;                   // [first, last]
+
+        // strings are stored in the file
+        void write(const std::string& filename) const;
+        static bitmap_index_t read(const std::string& filename);
+
+      private:
+        struct string_hash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+        };
+
+        // by value, not by id: ids of parsed_columns_t are specific to its pool
+        using string_bitmaps_t = std::unordered_map<std::string, row_bitmap_t, string_hash, std::equal_to<>>;
+
+        size_t size_{0};
+        std::map<subtype_code_t, row_bitmap_t> subtype_{};
+        std::map<uint16_t, row_bitmap_t> year_{};
+        string_bitmaps_t host_{};
+        string_bitmaps_t location_{};
+        string_bitmaps_t country_{};
+        string_bitmaps_t continent_{};
+
+        static const row_bitmap_t& not_found();
+        static const row_bitmap_t& find(const auto& bitmaps, auto key)
+        {
+            if (const auto found = bitmaps.find(key); found != bitmaps.end())
+                return found->second;
+            return not_found();
+        }
+    };
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
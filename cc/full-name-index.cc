@@ -0,0 +1,91 @@
+#include <cctype>
+
+#include "acmacs-base/string-strip.hh"
+#include "acmacs-base/string-join.hh"
+#include "acmacs-virus/virus-name-v1.hh"
+#include "acmacs-virus/full-name-index.hh"
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::full_name_index_t::entry_t acmacs::virus::full_name_index_t::split(std::string_view full_name)
+{
+    const auto name = virus_name::name(full_name);
+    entry_t entry{.name = normalize(name), .reassortant = Reassortant{}, .passage = Passage{}, .extra = std::string{}};
+    if (const auto rest = acmacs::string::strip(full_name.substr(name.size())); !rest.empty()) {
+        std::string extra;
+        std::tie(entry.reassortant, extra) = parse_reassortant(rest);
+        std::tie(entry.passage, entry.extra) = parse_passage(acmacs::string::strip(extra), passage_only::no);
+        entry.extra = acmacs::string::strip(entry.extra);
+    }
+    return entry;
+
+} // acmacs::virus::full_name_index_t::split
+
+// ----------------------------------------------------------------------
+
+std::string acmacs::virus::full_name_index_t::normalize(std::string_view source)
+{
+    std::string result;
+    result.reserve(source.size());
+    for (const char sym : acmacs::string::strip(source)) {
+        if (std::isspace(static_cast<unsigned char>(sym))) {
+            if (result.back() != ' ') // source is stripped, result is not empty
+                result.append(1, ' ');
+        }
+        else
+            result.append(1, static_cast<char>(std::toupper(static_cast<unsigned char>(sym))));
+    }
+    return result;
+
+} // acmacs::virus::full_name_index_t::normalize
+
+// ----------------------------------------------------------------------
+
+std::string acmacs::virus::full_name_index_t::canonical(const entry_t& entry)
+{
+    return normalize(acmacs::string::join(acmacs::string::join_space, entry.name, *entry.reassortant, *entry.passage, entry.extra));
+
+} // acmacs::virus::full_name_index_t::canonical
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::full_name_index_t::index_t acmacs::virus::full_name_index_t::add(std::string_view full_name)
+{
+    const index_t index = entries_.size();
+    auto& entry = entries_.emplace_back(split(full_name));
+    by_name_[entry.name].push_back(index);
+    // the first inserted one of the same split entry is found by both keys
+    const auto first = by_full_name_.try_emplace(canonical(entry), index).first->second;
+    by_full_name_.try_emplace(normalize(full_name), first);
+    return index;
+
+} // acmacs::virus::full_name_index_t::add
+
+// ----------------------------------------------------------------------
+
+std::optional<acmacs::virus::full_name_index_t::index_t> acmacs::virus::full_name_index_t::find(std::string_view full_name) const
+{
+    if (const auto found = by_full_name_.find(normalize(full_name)); found != by_full_name_.end())
+        return found->second;
+    return std::nullopt;
+
+} // acmacs::virus::full_name_index_t::find
+
+// ----------------------------------------------------------------------
+
+const acmacs::virus::full_name_index_t::indexes_t& acmacs::virus::full_name_index_t::find_by_name(std::string_view full_name) const
+{
+#include "acmacs-base/global-constructors-push.hh"
+    static const indexes_t not_found;
+#include "acmacs-base/diagnostics-pop.hh"
+
+    if (const auto found = by_name_.find(normalize(virus_name::name(full_name))); found != by_name_.end())
+        return found->second;
+    return not_found;
+
+} // acmacs::virus::full_name_index_t::find_by_name
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+#include "acmacs-virus/reassortant.hh"
+#include "acmacs-virus/passage.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2
+{
+    // Index of full names ("name reassortant passage extra", e.g. of chart
+    // antigens) for find_by_full_name style lookups. Each full name is split
+    // once on insertion: name part is extracted by virus_name::name() and
+    // normalized, reassortant and passage are parsed from the rest. find()
+    // does not split queries: the query is normalized and looked up among
+    // inserted full names and their canonical forms ("name reassortant
+    // passage extra" of the split entry), both normalized. find_by_name()
+    // extracts name part of the query by virus_name::name().
+    class full_name_index_t
+    {
+      public:
+        using index_t = size_t; // in the order of insertion
+        using indexes_t = std::vector<index_t>;
+
+        struct entry_t
+        {
+            std::string name; // normalized
+            Reassortant reassortant;
+            Passage passage;
+            std::string extra;
+        };
+
+        full_name_index_t() = default;
+        template <typename Iter> full_name_index_t(Iter first, Iter last)
+        {
+            for (; first != last; ++first)
+                add(*first);
+        }
+
+        // returns index of the inserted full name
+        index_t add(std::string_view full_name);
+
+        size_t size() const { return entries_.size(); }
+        bool empty() const { return entries_.empty(); }
+        const entry_t& operator[](index_t index) const { return entries_[index]; }
+
+        // first inserted full name with the same name, reassortant, passage
+        // and extra as the inserted full name or canonical form that is equal
+        // to full_name after normalization
+        std::optional<index_t> find(std::string_view full_name) const;
+        // all inserted full names with the same normalized name part, name part of the argument is used
+        const indexes_t& find_by_name(std::string_view full_name) const;
+
+        static entry_t split(std::string_view full_name);
+        // uppercased, spaces stripped and runs of spaces replaced with one space
+        static std::string normalize(std::string_view source);
+
+      private:
+        struct string_hash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+        };
+
+        std::vector<entry_t> entries_{};
+        std::unordered_map<std::string, indexes_t, string_hash, std::equal_to<>> by_name_{};
+        std::unordered_map<std::string, index_t, string_hash, std::equal_to<>> by_full_name_{}; // normalized full name or canonical form
+
+        static std::string canonical(const entry_t& entry);
+    };
+
+} // namespace acmacs::virus::inline v2
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
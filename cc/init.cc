@@ -0,0 +1,143 @@
+#include <array>
+#include <future>
+#include <mutex>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+#include "acmacs-base/string-from-chars.hh"
+#include "locationdb/locdb.hh"
+#include "acmacs-virus/init.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::detail
+{
+    // defined next to the function local statics they compile
+    void init_passage();          // passage.cc
+    void init_reassortant();      // reassortant.cc
+    void init_name_subtype();     // virus-name-normalize.cc
+    void init_name_mutations();   // virus-name-normalize.cc
+    void init_name_reassortant(); // virus-name-normalize.cc
+    void init_name_extra();       // virus-name-normalize.cc
+
+} // namespace acmacs::virus::inline v2::detail
+
+// ----------------------------------------------------------------------
+
+using init_group_t = std::pair<std::string_view, void (*)()>;
+
+// regexes at file scope (passage.cc, virus-name-v1.cc) are compiled by global constructors when the library is loaded
+constexpr const std::array init_groups{
+    init_group_t{"locationdb", [] { acmacs::locationdb::get(); }},
+    init_group_t{"passage", &acmacs::virus::detail::init_passage},
+    init_group_t{"reassortant", &acmacs::virus::detail::init_reassortant},
+    init_group_t{"name-subtype", &acmacs::virus::detail::init_name_subtype},
+    init_group_t{"name-mutations", &acmacs::virus::detail::init_name_mutations},
+    init_group_t{"name-reassortant", &acmacs::virus::detail::init_name_reassortant},
+    init_group_t{"name-extra", &acmacs::virus::detail::init_name_extra}, // uses reassortant, mutation and passage regexes
+};
+
+// ----------------------------------------------------------------------
+
+// bytes allocated on heap (all arenas), std::nullopt if not available
+static std::optional<size_t> heap_in_use()
+{
+#if defined(__GLIBC__)
+    // mallinfo2() reports main arena only, regexes compiled in other threads are allocated in other arenas
+    char* buffer{nullptr};
+    size_t size{0};
+    FILE* out = open_memstream(&buffer, &size);
+    if (out == nullptr)
+        return std::nullopt;
+    malloc_info(0, out);
+    std::fclose(out);
+    const std::string_view info{buffer, size};
+    // totals for all arenas follow the last </heap>
+    const auto totals_start = info.rfind("</heap>");
+    const auto total = [info, totals_start](std::string_view tag) -> size_t {
+        if (const auto tag_pos = info.find(tag, totals_start); tag_pos != std::string_view::npos) {
+            if (const auto size_pos = info.find("size=\"", tag_pos); size_pos != std::string_view::npos) {
+                const auto value = info.substr(size_pos + 6, info.find('"', size_pos + 6) - size_pos - 6);
+                return acmacs::string::from_chars<size_t>(value);
+            }
+        }
+        return 0;
+    };
+    std::optional<size_t> result;
+    if (totals_start != std::string_view::npos)
+        result = total(R"(<system type="current")") + total(R"(<total type="mmap")") - total(R"(<total type="fast")") - total(R"(<total type="rest")");
+    std::free(buffer);
+    return result;
+#elif defined(__APPLE__)
+    malloc_statistics_t stats;
+    malloc_zone_statistics(nullptr, &stats);
+    return stats.size_in_use;
+#else
+    return std::nullopt;
+#endif
+
+} // heap_in_use
+
+// ----------------------------------------------------------------------
+
+static inline std::optional<size_t> heap_growth(const std::optional<size_t>& before, const std::optional<size_t>& after)
+{
+    if (before.has_value() && after.has_value())
+        return *after > *before ? *after - *before : 0;
+    else
+        return std::nullopt;
+
+} // heap_growth
+
+// ----------------------------------------------------------------------
+
+const acmacs::virus::init_report_t& acmacs::virus::init(init_parallel parallel)
+{
+#include "acmacs-base/global-constructors-push.hh"
+    static init_report_t report;
+    static std::once_flag once;
+#include "acmacs-base/diagnostics-pop.hh"
+
+    std::call_once(once, [parallel]() {
+        using clock_t = std::chrono::steady_clock;
+        const auto run_group = [](const init_group_t& group, bool measure_memory) -> init_report_t::group_t {
+            const auto memory_before = measure_memory ? heap_in_use() : std::nullopt;
+            const auto start = clock_t::now();
+            group.second();
+            const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - start);
+            return {.name = group.first, .elapsed = elapsed, .memory = measure_memory ? heap_growth(memory_before, heap_in_use()) : std::nullopt};
+        };
+
+        report.parallel = parallel;
+        const auto memory_before = heap_in_use();
+        const auto start = clock_t::now();
+        switch (parallel) {
+            case init_parallel::no:
+                for (const auto& group : init_groups)
+                    report.groups.push_back(run_group(group, true));
+                break;
+            case init_parallel::yes: {
+                std::vector<std::future<init_report_t::group_t>> futures;
+                for (const auto& group : init_groups)
+                    futures.push_back(std::async(std::launch::async, run_group, std::cref(group), false));
+                for (auto& future : futures)
+                    report.groups.push_back(future.get());
+            } break;
+        }
+        report.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - start);
+        report.memory = heap_growth(memory_before, heap_in_use());
+    });
+    return report;
+
+} // acmacs::virus::init
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
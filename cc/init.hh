@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include "acmacs-base/fmt.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2
+{
+    enum class init_parallel { no, yes };
+
+    struct init_report_t
+    {
+        struct group_t
+        {
+            std::string_view name;
+            std::chrono::microseconds elapsed;
+            std::optional<size_t> memory{}; // heap growth, measured for sequential initialization only
+        };
+
+        std::vector<group_t> groups{};
+        std::chrono::microseconds elapsed{0}; // wall time of the whole initialization
+        std::optional<size_t> memory{};       // heap growth, std::nullopt if heap usage cannot be obtained on this platform
+        init_parallel parallel{init_parallel::no};
+    };
+
+    // Compiles all static regexes used by name, passage and reassortant
+    // parsing and loads locationdb, so that the first parsed names do not
+    // pay for that. Subsequent calls do nothing and return the report of the first call.
+    const init_report_t& init(init_parallel parallel = init_parallel::yes);
+
+} // namespace acmacs::virus::inline v2
+
+// ----------------------------------------------------------------------
+
+template <> struct fmt::formatter<acmacs::virus::init_report_t> : public fmt::formatter<acmacs::fmt_helper::default_formatter>
+{
+    template <typename FormatContext> auto format(const acmacs::virus::init_report_t& report, FormatContext& ctx)
+    {
+        const auto memory = [](const std::optional<size_t>& mem) { return mem.has_value() ? fmt::format("{:.1f}Mb", static_cast<double>(*mem) / 1024.0 / 1024.0) : std::string{"unknown"}; };
+
+        fmt::format_to(ctx.out(), "acmacs-virus init ({}): {:.3f}s memory: {}", report.parallel == acmacs::virus::init_parallel::yes ? "parallel" : "sequential",
+                       static_cast<double>(report.elapsed.count()) / 1e6, memory(report.memory));
+        for (const auto& group : report.groups) {
+            fmt::format_to(ctx.out(), "\n    {:<20s} {:8.3f}s", group.name, static_cast<double>(group.elapsed.count()) / 1e6);
+            if (group.memory.has_value())
+                fmt::format_to(ctx.out(), " {}", memory(group.memory));
+        }
+        return ctx.out();
+    }
+};
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
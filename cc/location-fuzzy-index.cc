@@ -0,0 +1,137 @@
+#include <algorithm>
+
+#include "acmacs-base/string.hh"
+#include "acmacs-virus/location-fuzzy-index.hh"
+#include "acmacs-virus/parallel.hh"
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::fuzzy_location_index_t::add(std::string_view location)
+{
+    auto upper = ::string::upper(location); // find() is case insensitive
+    if (upper.empty() || ids_.contains(upper))
+        return;
+    const auto id = static_cast<uint32_t>(locations_.size());
+    const auto& stored = locations_.emplace_back(std::move(upper)); // deque does not move elements on emplace_back
+    ids_.emplace(std::string_view{stored}, id);
+    for (const auto hash : deletions(stored))
+        deletions_[hash].push_back(id);
+
+} // acmacs::virus::name::fuzzy_location_index_t::add
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::fuzzy_location_index_t::add(const parsed_fields_t& fields)
+{
+    if (!fields.country.empty())
+        add(fields.location);
+
+} // acmacs::virus::name::fuzzy_location_index_t::add
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::fuzzy_location_index_t::add(const parsed_columns_t& columns)
+{
+    for (size_t row = 0; row < columns.size(); ++row) {
+        if (columns.country[row] != parsed_columns_t::no_id)
+            add(columns[columns.location[row]]);
+    }
+
+} // acmacs::virus::name::fuzzy_location_index_t::add
+
+// ----------------------------------------------------------------------
+
+std::vector<uint64_t> acmacs::virus::name::fuzzy_location_index_t::deletions(std::string_view source) const
+{
+    std::vector<uint64_t> hashes{std::hash<std::string_view>{}(source)};
+    std::vector<std::string> level{std::string{source}}, next_level;
+    for (size_t distance = 1; distance <= max_distance_; ++distance) {
+        next_level.clear();
+        for (const auto& str : level) {
+            for (size_t pos = 0; pos < str.size(); ++pos)
+                next_level.push_back(std::string{str}.erase(pos, 1));
+        }
+        std::sort(next_level.begin(), next_level.end());
+        next_level.erase(std::unique(next_level.begin(), next_level.end()), next_level.end());
+        std::transform(next_level.begin(), next_level.end(), std::back_inserter(hashes), [](const auto& str) { return std::hash<std::string_view>{}(str); });
+        std::swap(level, next_level);
+    }
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+    return hashes;
+
+} // acmacs::virus::name::fuzzy_location_index_t::deletions
+
+// ----------------------------------------------------------------------
+
+size_t acmacs::virus::name::fuzzy_location_index_t::distance(std::string_view s1, std::string_view s2, size_t max_distance)
+{
+    if ((s1.size() > s2.size() ? s1.size() - s2.size() : s2.size() - s1.size()) > max_distance)
+        return max_distance + 1;
+
+    // rows of the distance matrix: before previous, previous, current
+    std::vector<size_t> row2(s2.size() + 1), row1(s2.size() + 1), row0(s2.size() + 1);
+    for (size_t pos2 = 0; pos2 <= s2.size(); ++pos2)
+        row1[pos2] = pos2;
+    for (size_t pos1 = 1; pos1 <= s1.size(); ++pos1) {
+        row0[0] = pos1;
+        size_t row_min = row0[0];
+        for (size_t pos2 = 1; pos2 <= s2.size(); ++pos2) {
+            const size_t cost = s1[pos1 - 1] == s2[pos2 - 1] ? 0 : 1;
+            row0[pos2] = std::min({row1[pos2] + 1, row0[pos2 - 1] + 1, row1[pos2 - 1] + cost});
+            if (pos1 > 1 && pos2 > 1 && s1[pos1 - 1] == s2[pos2 - 2] && s1[pos1 - 2] == s2[pos2 - 1])
+                row0[pos2] = std::min(row0[pos2], row2[pos2 - 2] + 1); // transposition
+            row_min = std::min(row_min, row0[pos2]);
+        }
+        if (row_min > max_distance)
+            return max_distance + 1;
+        std::swap(row2, row1);
+        std::swap(row1, row0);
+    }
+    return std::min(row1[s2.size()], max_distance + 1);
+
+} // acmacs::virus::name::fuzzy_location_index_t::distance
+
+// ----------------------------------------------------------------------
+
+std::vector<acmacs::virus::name::fuzzy_location_index_t::candidate_t> acmacs::virus::name::fuzzy_location_index_t::find(std::string_view location, size_t max_candidates) const
+{
+    const auto look_for = ::string::upper(location);
+    std::vector<uint32_t> ids;
+    for (const auto hash : deletions(look_for)) {
+        if (const auto found = deletions_.find(hash); found != deletions_.end())
+            ids.insert(ids.end(), found->second.begin(), found->second.end());
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::vector<candidate_t> candidates;
+    for (const auto id : ids) {
+        if (const auto dist = distance(look_for, locations_[id], max_distance_); dist <= max_distance_)
+            candidates.push_back(candidate_t{.location = locations_[id], .distance = dist});
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& c1, const auto& c2) { return c1.distance == c2.distance ? c1.location < c2.location : c1.distance < c2.distance; });
+    if (candidates.size() > max_candidates)
+        candidates.erase(std::next(candidates.begin(), static_cast<std::ptrdiff_t>(max_candidates)), candidates.end());
+    return candidates;
+
+} // acmacs::virus::name::fuzzy_location_index_t::find
+
+// ----------------------------------------------------------------------
+
+std::vector<acmacs::virus::name::fuzzy_location_index_t::resolution_t> acmacs::virus::name::fuzzy_location_index_t::find(const not_found_locations_t& not_found, size_t max_candidates, size_t threads) const
+{
+    const auto entries = not_found.ranked();
+    std::vector<resolution_t> result(entries.size());
+    detail::in_parallel(detail::number_of_threads(threads), entries.size(), 1, [&](size_t first, size_t last) {
+        for (; first < last; ++first)
+            result[first] = resolution_t{.location = entries[first].location, .count = entries[first].count, .candidates = find(entries[first].location, max_candidates)};
+    });
+    return result;
+
+} // acmacs::virus::name::fuzzy_location_index_t::find
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
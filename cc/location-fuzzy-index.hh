@@ -0,0 +1,72 @@
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+
+#include "acmacs-virus/virus-name-normalize.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    // Approximate matching of locations not found in locationdb against
+    // known locations (e.g. "DELISERDANG" -> "DELI SERDANG"), to be queried
+    // on misses only. Symmetric delete index: every string made by deleting
+    // up to max_distance characters from a known location is indexed, a
+    // query generates its own deletions and looks them up, candidates are
+    // then verified by edit distance (insertions, deletions, substitutions
+    // and transpositions of adjacent characters).
+    //
+    // locationdb cannot enumerate its names, known locations are added
+    // explicitly or taken from parse results where location was found in
+    // locationdb (country is known).
+    class fuzzy_location_index_t
+    {
+      public:
+        struct candidate_t
+        {
+            std::string_view location;
+            size_t distance;
+        };
+
+        struct resolution_t
+        {
+            std::string location; // not found
+            size_t count;         // times not found
+            std::vector<candidate_t> candidates;
+        };
+
+        explicit fuzzy_location_index_t(size_t max_distance = 2) : max_distance_{max_distance} {}
+        fuzzy_location_index_t(const fuzzy_location_index_t&) = delete;
+        fuzzy_location_index_t& operator=(const fuzzy_location_index_t&) = delete;
+
+        void add(std::string_view location); // stored uppercased
+        void add(const parsed_fields_t& fields);
+        void add(const parsed_columns_t& columns);
+
+        size_t size() const { return locations_.size(); }
+        size_t max_distance() const { return max_distance_; }
+
+        // known locations within max_distance() of location (case insensitive), the closest first
+        std::vector<candidate_t> find(std::string_view location, size_t max_candidates = 5) const;
+        // all misses collected by parsers, in parallel (threads: 0 - hardware concurrency), most frequent misses first
+        std::vector<resolution_t> find(const not_found_locations_t& not_found, size_t max_candidates = 5, size_t threads = 0) const;
+
+        // optimal string alignment distance, max_distance + 1 if greater than max_distance
+        static size_t distance(std::string_view s1, std::string_view s2, size_t max_distance);
+
+      private:
+        size_t max_distance_;
+        std::deque<std::string> locations_{};
+        std::unordered_map<std::string_view, uint32_t> ids_{};
+        std::unordered_map<uint64_t, std::vector<uint32_t>> deletions_{}; // hash of deletion -> ids of locations, hash collisions are filtered by distance check
+
+        std::vector<uint64_t> deletions(std::string_view source) const; // hashes of source and its deletions, sorted, unique
+    };
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
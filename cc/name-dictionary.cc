@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "acmacs-base/fmt.hh"
+#include "acmacs-virus/name-dictionary.hh"
+
+// ----------------------------------------------------------------------
+// Block layout:
+//   header: magic (8 bytes), number of names, bucket size, number of buckets (uint64_t each)
+//   offsets of buckets in entries: number of buckets + 1 (uint64_t each), the last one is the size of entries
+//   entries of each bucket:
+//     first name: varint length, name
+//     other names: varint length of the prefix shared with the previous name, varint length of the rest, the rest
+// ----------------------------------------------------------------------
+
+static constexpr std::string_view sMagic{"ACVNDIC1"};
+static constexpr size_t sHeaderSize = sMagic.size() + 3 * sizeof(uint64_t);
+
+static inline void append_uint64(std::string& target, uint64_t value)
+{
+    target.append(reinterpret_cast<const char*>(&value), sizeof(value));
+
+} // append_uint64
+
+static inline uint64_t read_uint64(const char* source)
+{
+    uint64_t value;
+    std::memcpy(&value, source, sizeof(value)); // source may be unaligned
+    return value;
+
+} // read_uint64
+
+static inline void append_varint(std::string& target, size_t value)
+{
+    for (; value >= 0x80; value >>= 7)
+        target.append(1, static_cast<char>((value & 0x7F) | 0x80));
+    target.append(1, static_cast<char>(value));
+
+} // append_varint
+
+static inline size_t read_varint(const char* source, size_t& pos)
+{
+    size_t value{0};
+    for (size_t shift = 0;; shift += 7) {
+        const auto byte = static_cast<unsigned char>(source[pos++]);
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+
+} // read_varint
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name_dictionary_t::name_dictionary_t(std::span<const name_t> names, size_t bucket_size)
+{
+    if (bucket_size == 0)
+        throw std::invalid_argument{"name_dictionary_t: bucket_size must be positive"};
+
+    std::vector<std::string_view> sorted(names.size());
+    std::transform(names.begin(), names.end(), sorted.begin(), [](const auto& name) { return std::string_view{*name}; });
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    if (sorted.size() > std::numeric_limits<id_t>::max())
+        throw std::invalid_argument{fmt::format("name_dictionary_t: too many names: {}", sorted.size())};
+
+    const size_t number_of_buckets = (sorted.size() + bucket_size - 1) / bucket_size;
+    std::string entries;
+    std::vector<uint64_t> offsets;
+    offsets.reserve(number_of_buckets + 1);
+    for (size_t no = 0; no < sorted.size(); ++no) {
+        if ((no % bucket_size) == 0) {
+            offsets.push_back(entries.size());
+            append_varint(entries, sorted[no].size());
+            entries.append(sorted[no]);
+        }
+        else {
+            const auto& previous = sorted[no - 1];
+            const auto common = static_cast<size_t>(std::mismatch(previous.begin(), previous.end(), sorted[no].begin(), sorted[no].end()).first - previous.begin());
+            append_varint(entries, common);
+            append_varint(entries, sorted[no].size() - common);
+            entries.append(sorted[no].substr(common));
+        }
+    }
+    offsets.push_back(entries.size());
+
+    block_.reserve(sHeaderSize + offsets.size() * sizeof(uint64_t) + entries.size());
+    block_.append(sMagic);
+    append_uint64(block_, sorted.size());
+    append_uint64(block_, bucket_size);
+    append_uint64(block_, number_of_buckets);
+    for (const auto offset : offsets)
+        append_uint64(block_, offset);
+    block_.append(entries);
+    attach(block_);
+
+} // acmacs::virus::name_dictionary_t::name_dictionary_t
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name_dictionary_t::~name_dictionary_t()
+{
+    if (mapped_ != nullptr)
+        ::munmap(mapped_, data_.size());
+
+} // acmacs::virus::name_dictionary_t::~name_dictionary_t
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name_dictionary_t& acmacs::virus::name_dictionary_t::operator=(name_dictionary_t&& src) noexcept
+{
+    if (this != &src) {
+        if (mapped_ != nullptr)
+            ::munmap(mapped_, data_.size());
+        mapped_ = std::exchange(src.mapped_, nullptr);
+        const auto data = std::exchange(src.data_, std::string_view{});
+        block_ = std::move(src.block_); // small block may be stored inside string, pointers have to be re-attached
+        src.attach({});
+        if (mapped_ != nullptr)
+            attach(data);
+        else
+            attach(block_);
+    }
+    return *this;
+
+} // acmacs::virus::name_dictionary_t::operator=
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name_dictionary_t::attach(std::string_view data)
+{
+    data_ = data;
+    if (data_.empty()) {
+        size_ = number_of_buckets_ = 0;
+        offsets_ = entries_ = nullptr;
+        return;
+    }
+
+    if (data_.size() < sHeaderSize || data_.substr(0, sMagic.size()) != sMagic)
+        throw std::runtime_error{"name_dictionary_t: invalid data"};
+    size_ = read_uint64(data_.data() + sMagic.size());
+    bucket_size_ = read_uint64(data_.data() + sMagic.size() + sizeof(uint64_t));
+    number_of_buckets_ = read_uint64(data_.data() + sMagic.size() + 2 * sizeof(uint64_t));
+    offsets_ = data_.data() + sHeaderSize;
+    entries_ = offsets_ + (number_of_buckets_ + 1) * sizeof(uint64_t);
+    if (bucket_size_ == 0 || number_of_buckets_ != (size_ + bucket_size_ - 1) / bucket_size_ || static_cast<size_t>(entries_ - data_.data()) > data_.size() ||
+        bucket_offset(number_of_buckets_) != data_.size() - static_cast<size_t>(entries_ - data_.data()))
+        throw std::runtime_error{"name_dictionary_t: invalid data"};
+
+} // acmacs::virus::name_dictionary_t::attach
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name_dictionary_t acmacs::virus::name_dictionary_t::map(const std::string& filename)
+{
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error{fmt::format("name_dictionary_t: cannot open {}: {}", filename, std::strerror(errno))};
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error{fmt::format("name_dictionary_t: cannot map {}: empty or not a regular file", filename)};
+    }
+    void* mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // mapping stays valid
+    if (mapped == MAP_FAILED)
+        throw std::runtime_error{fmt::format("name_dictionary_t: cannot map {}: {}", filename, std::strerror(errno))};
+
+    name_dictionary_t dictionary;
+    dictionary.mapped_ = mapped;
+    dictionary.attach(std::string_view{static_cast<const char*>(mapped), static_cast<size_t>(st.st_size)}); // mapping is released by the destructor if attach throws
+    return dictionary;
+
+} // acmacs::virus::name_dictionary_t::map
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name_dictionary_t::write(const std::string& filename) const
+{
+    std::ofstream output{filename, std::ios::binary | std::ios::trunc};
+    if (!output.write(data_.data(), static_cast<std::streamsize>(data_.size())))
+        throw std::runtime_error{fmt::format("name_dictionary_t: cannot write {}", filename)};
+
+} // acmacs::virus::name_dictionary_t::write
+
+// ----------------------------------------------------------------------
+
+size_t acmacs::virus::name_dictionary_t::bucket_offset(size_t bucket_no) const
+{
+    return read_uint64(offsets_ + bucket_no * sizeof(uint64_t));
+
+} // acmacs::virus::name_dictionary_t::bucket_offset
+
+// ----------------------------------------------------------------------
+
+std::string_view acmacs::virus::name_dictionary_t::bucket_head(size_t bucket_no) const
+{
+    size_t pos = bucket_offset(bucket_no);
+    const auto length = read_varint(entries_, pos);
+    return {entries_ + pos, length};
+
+} // acmacs::virus::name_dictionary_t::bucket_head
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name_dictionary_t::next(cursor_t& cursor) const
+{
+    if ((cursor.id % bucket_size_) == 0) {
+        cursor.pos = bucket_offset(cursor.id / bucket_size_);
+        const auto length = read_varint(entries_, cursor.pos);
+        cursor.name.assign(entries_ + cursor.pos, length);
+        cursor.pos += length;
+    }
+    else {
+        const auto common = read_varint(entries_, cursor.pos);
+        const auto rest = read_varint(entries_, cursor.pos);
+        cursor.name.resize(common);
+        cursor.name.append(entries_ + cursor.pos, rest);
+        cursor.pos += rest;
+    }
+
+} // acmacs::virus::name_dictionary_t::next
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name_dictionary_t::seek(cursor_t& cursor, id_t id) const
+{
+    if (id >= size_)
+        throw std::out_of_range{fmt::format("name_dictionary_t: invalid id {}, size: {}", id, size_)};
+    for (cursor.id = static_cast<id_t>(id - id % bucket_size_); ; ++cursor.id) {
+        next(cursor);
+        if (cursor.id == id)
+            break;
+    }
+
+} // acmacs::virus::name_dictionary_t::seek
+
+// ----------------------------------------------------------------------
+
+std::string acmacs::virus::name_dictionary_t::operator[](id_t id) const
+{
+    cursor_t cursor;
+    seek(cursor, id);
+    return std::move(cursor.name);
+
+} // acmacs::virus::name_dictionary_t::operator[]
+
+// ----------------------------------------------------------------------
+
+template <typename Pred> acmacs::virus::name_dictionary_t::id_t acmacs::virus::name_dictionary_t::partition_point(Pred pred) const
+{
+    // first bucket whose head fails pred, the partition point is in the preceding bucket
+    size_t first_bucket{0}, last_bucket{number_of_buckets_};
+    while (first_bucket < last_bucket) {
+        const auto middle = first_bucket + (last_bucket - first_bucket) / 2;
+        if (pred(bucket_head(middle)))
+            first_bucket = middle + 1;
+        else
+            last_bucket = middle;
+    }
+    if (first_bucket == 0)
+        return 0;
+
+    const auto first = static_cast<id_t>((first_bucket - 1) * bucket_size_), last = static_cast<id_t>(std::min(first_bucket * bucket_size_, size_));
+    cursor_t cursor{.id = first};
+    for (; cursor.id < last; ++cursor.id) {
+        next(cursor);
+        if (!pred(std::string_view{cursor.name}))
+            break;
+    }
+    return cursor.id;
+
+} // acmacs::virus::name_dictionary_t::partition_point
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name_dictionary_t::id_t acmacs::virus::name_dictionary_t::lower_bound(std::string_view name) const
+{
+    return partition_point([name](std::string_view stored) { return stored < name; });
+
+} // acmacs::virus::name_dictionary_t::lower_bound
+
+// ----------------------------------------------------------------------
+
+std::optional<acmacs::virus::name_dictionary_t::id_t> acmacs::virus::name_dictionary_t::find(std::string_view name) const
+{
+    const auto id = partition_point([name](std::string_view stored) { return stored < name; });
+    if (id < size_ && (*this)[id] == name)
+        return id;
+    return std::nullopt;
+
+} // acmacs::virus::name_dictionary_t::find
+
+// ----------------------------------------------------------------------
+
+std::pair<acmacs::virus::name_dictionary_t::id_t, acmacs::virus::name_dictionary_t::id_t> acmacs::virus::name_dictionary_t::prefix_range(std::string_view prefix) const
+{
+    const auto first = lower_bound(prefix);
+    // names starting with prefix follow the names less than prefix
+    const auto last = partition_point([prefix](std::string_view stored) { return stored < prefix || stored.starts_with(prefix); });
+    return {first, last};
+
+} // acmacs::virus::name_dictionary_t::prefix_range
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <span>
+#include <optional>
+#include <cstdint>
+
+#include "acmacs-virus/virus-name.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2
+{
+    // Read-only sorted set of names, front coded: names are split into
+    // buckets of bucket_size names, the first name of a bucket is stored in
+    // full, every other name as the length of the prefix shared with the
+    // previous name and the rest. Id of a name is its rank in the sorted
+    // set. Lookups are binary searches over the first names of buckets
+    // followed by decoding of a single bucket.
+    //
+    // Stored in a single block that is written to a file as is and used
+    // from a memory mapped file without decoding (native byte order).
+    class name_dictionary_t
+    {
+      public:
+        using id_t = uint32_t;
+        static constexpr size_t default_bucket_size{16};
+
+        name_dictionary_t() = default;
+        // names do not need to be sorted, duplicates are stored once
+        name_dictionary_t(std::span<const name_t> names, size_t bucket_size = default_bucket_size);
+        name_dictionary_t(const name_dictionary_t&) = delete;
+        name_dictionary_t(name_dictionary_t&& src) noexcept { *this = std::move(src); }
+        ~name_dictionary_t();
+        name_dictionary_t& operator=(const name_dictionary_t&) = delete;
+        name_dictionary_t& operator=(name_dictionary_t&& src) noexcept;
+
+        // memory maps file written by write(), throws std::runtime_error
+        static name_dictionary_t map(const std::string& filename);
+        void write(const std::string& filename) const;
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        // bytes used by the stored block
+        size_t storage_size() const { return data_.size(); }
+
+        // select: name with the id
+        std::string operator[](id_t id) const;
+        // rank: number of names less than name
+        id_t lower_bound(std::string_view name) const;
+        std::optional<id_t> find(std::string_view name) const;
+        // [first, last) range of ids of names starting with prefix, e.g. "A(H1N1)/TEXAS/"
+        std::pair<id_t, id_t> prefix_range(std::string_view prefix) const;
+
+        // calls func(id, name) for names in [first, last) in order,
+        // decoding is sequential, i.e. this is the fastest way to scan the
+        // dictionary, e.g. to select names of a year (last part of a name)
+        template <typename F> void for_each(id_t first, id_t last, F&& func) const
+        {
+            if (first >= last)
+                return;
+            cursor_t cursor;
+            seek(cursor, first);
+            for (func(cursor.id, std::string_view{cursor.name}); ++cursor.id < last; func(cursor.id, std::string_view{cursor.name}))
+                next(cursor);
+        }
+        template <typename F> void for_each(F&& func) const { for_each(0, static_cast<id_t>(size_), std::forward<F>(func)); }
+
+      private:
+        std::string block_{};           // owned storage, empty if mapped
+        void* mapped_{nullptr};
+        std::string_view data_{};       // block_ or mapped file
+        size_t size_{0};
+        size_t bucket_size_{default_bucket_size};
+        size_t number_of_buckets_{0};
+        const char* offsets_{nullptr};  // number_of_buckets_ + 1 uint64_t offsets of buckets in entries_
+        const char* entries_{nullptr};
+
+        struct cursor_t
+        {
+            id_t id{0};
+            size_t pos{0}; // in entries_ after the name
+            std::string name{};
+        };
+
+        void attach(std::string_view data);
+        size_t bucket_offset(size_t bucket_no) const;
+        std::string_view bucket_head(size_t bucket_no) const;
+        void seek(cursor_t& cursor, id_t id) const;
+        void next(cursor_t& cursor) const; // decodes name with cursor.id, which is the previous id + 1
+        // first id for which pred(name) is false, pred must be true for a prefix of the sorted names
+        template <typename Pred> id_t partition_point(Pred pred) const;
+    };
+
+} // namespace acmacs::virus::inline v2
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
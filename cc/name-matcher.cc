@@ -0,0 +1,200 @@
+#include <array>
+#include <algorithm>
+#include <numeric>
+
+#include "acmacs-base/string-from-chars.hh"
+#include "acmacs-virus/name-matcher.hh"
+#include "acmacs-virus/parallel.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    // Myers' bit-parallel edit distance (Hyyrö's formulation for the
+    // global distance): columns of the distance matrix for the pattern (up
+    // to 64 characters) are kept as bit vectors of vertical deltas, one text
+    // character is processed in a few word operations.
+    class myers_pattern_t
+    {
+      public:
+        static constexpr const size_t max_length{64};
+
+        myers_pattern_t(std::string_view pattern) : length_{pattern.size()}
+        {
+            peq_.fill(0);
+            for (size_t pos = 0; pos < pattern.size(); ++pos)
+                peq_[static_cast<unsigned char>(pattern[pos])] |= uint64_t{1} << pos;
+        }
+
+        size_t distance(std::string_view text) const
+        {
+            if (length_ == 0)
+                return text.size();
+            const uint64_t last = uint64_t{1} << (length_ - 1);
+            uint64_t pv{~uint64_t{0}}, mv{0};
+            size_t score{length_};
+            for (const char sym : text) {
+                const uint64_t eq = peq_[static_cast<unsigned char>(sym)];
+                const uint64_t xv = eq | mv;
+                const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+                uint64_t ph = mv | ~(xh | pv);
+                uint64_t mh = pv & xh;
+                if (ph & last)
+                    ++score;
+                else if (mh & last)
+                    --score;
+                ph = (ph << 1) | 1;
+                mh <<= 1;
+                pv = mh | ~(xv | ph);
+                mv = ph & xv;
+            }
+            return score;
+        }
+
+      private:
+        size_t length_;
+        std::array<uint64_t, 256> peq_;
+    };
+
+    // two row dynamic programming, for sources longer than myers_pattern_t::max_length
+    static inline size_t edit_distance_dp(std::string_view source1, std::string_view source2)
+    {
+        std::vector<size_t> previous(source2.size() + 1), current(source2.size() + 1);
+        std::iota(previous.begin(), previous.end(), size_t{0});
+        for (size_t pos1 = 1; pos1 <= source1.size(); ++pos1) {
+            current[0] = pos1;
+            for (size_t pos2 = 1; pos2 <= source2.size(); ++pos2)
+                current[pos2] = std::min({previous[pos2] + 1, current[pos2 - 1] + 1, previous[pos2 - 1] + (source1[pos1 - 1] == source2[pos2 - 1] ? 0 : 1)});
+            std::swap(previous, current);
+        }
+        return previous[source2.size()];
+    }
+
+    static inline double similarity(size_t distance, size_t length1, size_t length2)
+    {
+        if (const auto longer = std::max(length1, length2); longer > 0)
+            return 1.0 - static_cast<double>(distance) / static_cast<double>(longer);
+        else
+            return 1.0;
+    }
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::name_matcher_t::name_matcher_t(std::span<const parsed_fields_t> reference) : isolations_(reference.size())
+{
+    if (reference.size() > std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument{fmt::format("name_matcher_t: too many reference names: {}", reference.size())};
+    for (size_t no = 0; no < reference.size(); ++no) {
+        if (const auto key = block(reference[no]); key.has_value()) {
+            isolations_[no] = normalize_isolation(reference[no].isolation);
+            blocks_[std::move(*key)].push_back(static_cast<uint32_t>(no));
+        }
+    }
+
+} // acmacs::virus::name::name_matcher_t::name_matcher_t
+
+// ----------------------------------------------------------------------
+
+std::optional<std::string> acmacs::virus::name::name_matcher_t::block(const parsed_fields_t& fields)
+{
+    if (!fields.good())
+        return std::nullopt;
+    // good() means location is not empty and year has 4 characters
+    return fmt::format("{:04x}{:04x}{}", subtype_code(*fields.subtype), acmacs::string::from_chars<size_t>(fields.year) & 0xFFFF, fields.location);
+
+} // acmacs::virus::name::name_matcher_t::block
+
+// ----------------------------------------------------------------------
+
+std::string acmacs::virus::name::name_matcher_t::normalize_isolation(std::string_view isolation)
+{
+    const auto is_digit = [](char sym) { return sym >= '0' && sym <= '9'; };
+    const auto is_separator = [](char sym) { return sym == ' ' || sym == '-' || sym == '/' || sym == '.' || sym == '_'; };
+
+    std::string result;
+    result.reserve(isolation.size());
+    for (size_t pos = 0; pos < isolation.size(); ++pos) {
+        if (is_separator(isolation[pos])) {
+            if (!result.empty() && result.back() != '-')
+                result.append(1, '-');
+        }
+        else if (isolation[pos] == '0' && (result.empty() || !is_digit(result.back())) && (pos + 1) < isolation.size() && is_digit(isolation[pos + 1]))
+            ; // leading zero of a number
+        else
+            result.append(1, isolation[pos]);
+    }
+    if (!result.empty() && result.back() == '-')
+        result.pop_back();
+    return result;
+
+} // acmacs::virus::name::name_matcher_t::normalize_isolation
+
+// ----------------------------------------------------------------------
+
+size_t acmacs::virus::name::name_matcher_t::edit_distance(std::string_view source1, std::string_view source2)
+{
+    if (source1.size() > source2.size())
+        std::swap(source1, source2);
+    if (source1.size() <= myers_pattern_t::max_length)
+        return myers_pattern_t{source1}.distance(source2);
+    else
+        return edit_distance_dp(source1, source2);
+
+} // acmacs::virus::name::name_matcher_t::edit_distance
+
+// ----------------------------------------------------------------------
+
+double acmacs::virus::name::name_matcher_t::isolation_similarity(std::string_view isolation1, std::string_view isolation2)
+{
+    return similarity(edit_distance(isolation1, isolation2), isolation1.size(), isolation2.size());
+
+} // acmacs::virus::name::name_matcher_t::isolation_similarity
+
+// ----------------------------------------------------------------------
+
+std::optional<acmacs::virus::name::name_matcher_t::match_t> acmacs::virus::name::name_matcher_t::match(const parsed_fields_t& query, double min_score) const
+{
+    const auto key = block(query);
+    if (!key.has_value())
+        return std::nullopt;
+    const auto found = blocks_.find(*key);
+    if (found == blocks_.end())
+        return std::nullopt;
+
+    const auto isolation = normalize_isolation(query.isolation);
+    std::optional<myers_pattern_t> pattern; // built once for all references of the block
+    if (isolation.size() <= myers_pattern_t::max_length)
+        pattern.emplace(isolation);
+    std::optional<match_t> best;
+    for (const auto reference : found->second) {
+        const auto& ref_isolation = isolations_[reference];
+        const auto distance = pattern.has_value() ? pattern->distance(ref_isolation) : edit_distance_dp(isolation, ref_isolation);
+        if (const auto score = similarity(distance, isolation.size(), ref_isolation.size()); score >= min_score && (!best.has_value() || score > best->score)) {
+            best = match_t{.reference = reference, .score = score};
+            if (distance == 0)
+                break;
+        }
+    }
+    return best;
+
+} // acmacs::virus::name::name_matcher_t::match
+
+// ----------------------------------------------------------------------
+
+std::vector<std::optional<acmacs::virus::name::name_matcher_t::match_t>> acmacs::virus::name::name_matcher_t::match(std::span<const parsed_fields_t> queries, double min_score, size_t threads) const
+{
+    std::vector<std::optional<match_t>> result(queries.size());
+    detail::in_parallel(detail::number_of_threads(threads), queries.size(), 1, [&](size_t first, size_t last) {
+        for (; first < last; ++first)
+            result[first] = match(queries[first], min_score);
+    });
+    return result;
+
+} // acmacs::virus::name::name_matcher_t::match
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
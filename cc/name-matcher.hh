@@ -0,0 +1,58 @@
+#pragma once
+
+#include <span>
+#include <unordered_map>
+
+#include "acmacs-virus/virus-name-normalize.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    // Approximate matching of names, e.g. of antigens of different HI
+    // tables, that differ by isolation formatting or leading zeros
+    // ("A(H3N2)/HONG KONG/4801/2014" and "A/HongKong/04801/14"). Reference
+    // names are put into blocks by subtype, year and location (locationdb
+    // already maps location variants to the same name), a query is
+    // compared to references of its block only, by
+    // similarity of normalized isolations. Only good() parse results are
+    // matched.
+    class name_matcher_t
+    {
+      public:
+        struct match_t
+        {
+            size_t reference; // index in the reference span
+            double score;     // isolation similarity, 1.0 - the same normalized isolation
+        };
+
+        explicit name_matcher_t(std::span<const parsed_fields_t> reference);
+
+        size_t size() const { return isolations_.size(); }
+
+        // best match (the first reference of the highest score) with score >= min_score
+        std::optional<match_t> match(const parsed_fields_t& query, double min_score = 0.7) const;
+        // result is in the order of queries, threads: 0 - hardware concurrency
+        std::vector<std::optional<match_t>> match(std::span<const parsed_fields_t> queries, double min_score = 0.7, size_t threads = 0) const;
+
+        // leading zeros of numbers removed, runs of separators (space - / . _) replaced with -
+        static std::string normalize_isolation(std::string_view isolation);
+        // 1 - edit distance / length of the longer one, isolations are expected to be normalized
+        static double isolation_similarity(std::string_view isolation1, std::string_view isolation2);
+        // Levenshtein distance, bit-parallel (Myers) if the shorter one is not longer than 64
+        static size_t edit_distance(std::string_view source1, std::string_view source2);
+
+      private:
+        std::vector<std::string> isolations_{}; // normalized, empty for references not in any block
+        std::unordered_map<std::string, std::vector<uint32_t>> blocks_{};
+
+        // subtype code and year in hex followed by location
+        static std::optional<std::string> block(const parsed_fields_t& fields);
+    };
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
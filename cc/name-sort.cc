@@ -0,0 +1,110 @@
+#include <unordered_map>
+#include <numeric>
+
+#include "acmacs-base/string-from-chars.hh"
+#include "acmacs-virus/name-sort.hh"
+#include "acmacs-virus/parallel.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    constexpr const uint64_t isolation_without_number{0xFFFFFFFF};
+
+    static inline uint64_t isolation_key(std::string_view isolation)
+    {
+        uint64_t number{0};
+        size_t pos{0};
+        for (; pos < isolation.size() && isolation[pos] >= '0' && isolation[pos] <= '9'; ++pos)
+            number = std::min(number * 10 + static_cast<uint64_t>(isolation[pos] - '0'), isolation_without_number - 1);
+        if (pos == 0)
+            number = isolation_without_number;
+        uint64_t rest{0};
+        for (size_t no = 0; no < 4; ++no)
+            rest = (rest << 8) | (pos + no < isolation.size() ? static_cast<unsigned char>(isolation[pos + no]) : 0u);
+        return (number << 32) | rest;
+    }
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+
+std::vector<acmacs::virus::name::name_sort_key_t> acmacs::virus::name::sort_keys(std::span<const parsed_fields_t> fields, size_t threads)
+{
+    threads = detail::number_of_threads(threads);
+
+    // distinct locations are few, ranks are assigned serially, locations
+    // found in locationdb are hashed and compared by handle
+    std::unordered_map<maybe_interned_string_t, uint64_t> location_rank;
+    for (const auto& entry : fields)
+        location_rank.emplace(entry.location, 0);
+    std::vector<maybe_interned_string_t> locations(location_rank.size());
+    std::transform(location_rank.begin(), location_rank.end(), locations.begin(), [](const auto& en) { return en.first; });
+    std::sort(locations.begin(), locations.end());
+    for (size_t rank = 0; rank < locations.size(); ++rank)
+        location_rank[locations[rank]] = rank;
+
+    std::vector<name_sort_key_t> keys(fields.size());
+    detail::in_parallel(threads, fields.size(), 1, [&](size_t first, size_t last) {
+        for (; first < last; ++first) {
+            const auto& entry = fields[first];
+            const uint64_t year = entry.year.size() == 4 ? acmacs::string::from_chars<size_t>(entry.year) : 0;
+            keys[first] = name_sort_key_t{.high = (uint64_t{subtype_code(*entry.subtype)} << 48) | (location_rank.find(entry.location)->second << 16) | year, .low = isolation_key(entry.isolation)};
+        }
+    });
+    return keys;
+
+} // acmacs::virus::name::sort_keys
+
+// ----------------------------------------------------------------------
+
+std::vector<size_t> acmacs::virus::name::sorted_order(std::span<const parsed_fields_t> fields, size_t threads)
+{
+    threads = detail::number_of_threads(threads);
+    const auto keys = sort_keys(fields, threads);
+
+    std::vector<size_t> order(fields.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    const auto less = [&keys, &fields](size_t index1, size_t index2) {
+        if (const auto cmp = keys[index1] <=> keys[index2]; cmp != 0)
+            return cmp < 0;
+        if (const auto cmp = fields[index1].isolation <=> fields[index2].isolation; cmp != 0)
+            return cmp < 0;
+        if (const auto cmp = *fields[index1].host <=> *fields[index2].host; cmp != 0)
+            return cmp < 0;
+        return index1 < index2;
+    };
+
+    // chunk is aligned, so that in_parallel() runs exactly one range per thread
+    const auto at = [&order](size_t pos) { return std::next(order.begin(), static_cast<std::ptrdiff_t>(pos)); };
+    const auto chunk = std::max((order.size() + threads - 1) / threads, size_t{1});
+    detail::in_parallel(threads, order.size(), chunk, [&at, &less](size_t first, size_t last) { std::sort(at(first), at(last), less); });
+    for (size_t width = chunk; width < order.size(); width *= 2) {
+        detail::in_parallel(threads, (order.size() + width * 2 - 1) / (width * 2), 1, [&order, &at, &less, width](size_t first, size_t last) {
+            for (; first < last; ++first) {
+                const auto start = first * width * 2;
+                std::inplace_merge(at(start), at(std::min(start + width, order.size())), at(std::min(start + width * 2, order.size())), less);
+            }
+        });
+    }
+    return order;
+
+} // acmacs::virus::name::sorted_order
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::sort(std::span<parsed_fields_t> fields, size_t threads)
+{
+    const auto order = sorted_order(fields, threads);
+    std::vector<parsed_fields_t> sorted;
+    sorted.reserve(fields.size());
+    for (const auto index : order)
+        sorted.push_back(std::move(fields[index]));
+    std::move(sorted.begin(), sorted.end(), fields.begin());
+
+} // acmacs::virus::name::sort
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
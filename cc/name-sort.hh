@@ -0,0 +1,40 @@
+#pragma once
+
+#include <span>
+#include <compare>
+
+#include "acmacs-virus/virus-name-normalize.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    // Packed key ordering parse results by subtype, location, year, leading
+    // isolation number (isolation "9" is before "10", isolation without
+    // number is after numbers) and the first 4 characters of isolation after
+    // that number. Locations are ordered by their ranks among the parse
+    // results the keys are made for, i.e. keys are comparable only within one
+    // sort_keys() result.
+    struct name_sort_key_t
+    {
+        uint64_t high{0}; // subtype_code_t (16 bits), location rank (32 bits), year (16 bits)
+        uint64_t low{0};  // leading isolation number (32 bits), next 4 characters of isolation
+
+        auto operator<=>(const name_sort_key_t&) const = default;
+    };
+
+    // threads: 0 - hardware concurrency
+    std::vector<name_sort_key_t> sort_keys(std::span<const parsed_fields_t> fields, size_t threads = 0);
+
+    // Indexes of fields in the order of their sort keys, equal keys are
+    // ordered by isolation, then by host, then by index. Parts of the key
+    // array are sorted in parallel, then merged pairwise in parallel.
+    std::vector<size_t> sorted_order(std::span<const parsed_fields_t> fields, size_t threads = 0);
+    void sort(std::span<parsed_fields_t> fields, size_t threads = 0);
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <future>
+#include <thread>
+#include <algorithm>
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::detail
+{
+    // 0 - hardware concurrency
+    inline size_t number_of_threads(size_t threads) { return threads == 0 ? std::max(std::thread::hardware_concurrency(), 1u) : threads; }
+
+    // runs func(first, last) for ranges of [0, size) in parallel, range sizes are multiples of alignment (except the last one)
+    template <typename Func> void in_parallel(size_t threads, size_t size, size_t alignment, Func func)
+    {
+        const auto chunk = std::max((size + threads * alignment - 1) / (threads * alignment), size_t{1}) * alignment;
+        std::vector<std::future<void>> futures;
+        for (size_t first = 0; first < size; first += chunk)
+            futures.push_back(std::async(std::launch::async, func, first, std::min(first + chunk, size)));
+        for (auto& future : futures)
+            future.get();
+    }
+
+} // namespace acmacs::virus::inline v2::detail
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <numeric>
 
 #include "acmacs-base/log.hh"
@@ -52,6 +53,322 @@ void acmacs::virus::v2::name::collect_not_found_locations(std::set<std::string>&
 
 // ----------------------------------------------------------------------
 
+std::string acmacs::virus::v2::name::make_message_text(message_format format, std::string_view refers_to, std::span<const uint32_t> numbers, std::span<const std::string_view> parts, std::string_view raw)
+{
+    const auto location_parts = [numbers]() {
+        fmt::memory_buffer text;
+        fmt::format_to(std::back_inserter(text), "{{");
+        for (const auto part_no : numbers)
+            fmt::format_to(std::back_inserter(text), " {}", part_no);
+        fmt::format_to(std::back_inserter(text), "}}");
+        return fmt::to_string(text);
+    };
+
+    switch (format) {
+        case message_format::text:
+            return std::string{refers_to};
+        case message_format::invalid_year:
+            return fmt::format("\"{}\" <- \"{}\"", refers_to, raw);
+        case message_format::numbered_parts:
+            return fmt::format("{} {}", numbers.empty() ? uint32_t{0} : numbers.front(), std::vector<std::string_view>(parts.begin(), parts.end()));
+        case message_format::joined_parts:
+            return acmacs::string::join(acmacs::string::join_slash, parts);
+        case message_format::location_parts:
+            return location_parts();
+        case message_format::location_parts_and_name:
+            return fmt::format("{} \"{}\"", location_parts(), acmacs::string::join(acmacs::string::join_slash, parts));
+    }
+    return std::string{refers_to};
+
+} // acmacs::virus::v2::name::make_message_text
+
+// ----------------------------------------------------------------------
+
+std::string acmacs::virus::v2::name::lazy_message_t::text(std::string_view raw) const
+{
+    if (!value.empty())
+        return value;
+    std::vector<std::string_view> part_views(parts.size());
+    std::transform(parts.begin(), parts.end(), part_views.begin(), [raw](const slice_t& slice) { return raw.substr(slice.offset, slice.length); });
+    return make_message_text(format, raw.substr(offset, length), numbers, part_views, raw);
+
+} // acmacs::virus::v2::name::lazy_message_t::text
+
+// ----------------------------------------------------------------------
+
+size_t acmacs::virus::v2::name::policy_messages_t::size() const noexcept
+{
+    if (!data_)
+        return 0;
+    return data_->lazy.size() + std::accumulate(std::begin(data_->counts), std::end(data_->counts), size_t{0});
+
+} // acmacs::virus::v2::name::policy_messages_t::size
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::policy_messages_t::clear() noexcept
+{
+    if (data_) {
+        data_->counts.fill(0);
+        data_->lazy.clear();
+    }
+
+} // acmacs::virus::v2::name::policy_messages_t::clear
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::v2::name::message_aggregator_t::per_key_t& acmacs::virus::v2::name::message_aggregator_t::count_message(const acmacs::messages::message_t& message)
+{
+    ++total_;
+    auto found = keys_.find(message.key);
+    if (found == keys_.end())
+        found = keys_.emplace(message.key, per_key_t{}).first;
+    ++found->second.count;
+    if (message.key == acmacs::messages::key::location_not_found)
+        count_value(message.value, 1);
+    return found->second;
+
+} // acmacs::virus::v2::name::message_aggregator_t::count_message
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::message_aggregator_t::add(const acmacs::messages::message_t& message)
+{
+    if (auto& per_key = count_message(message); per_key.examples.size() < examples_per_key_)
+        per_key.examples.push_back(message);
+
+} // acmacs::virus::v2::name::message_aggregator_t::add
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::message_aggregator_t::add(const acmacs::messages::messages_t& messages, const acmacs::messages::position_t& source)
+{
+    for (const auto& message : messages) {
+        if (auto& per_key = count_message(message); per_key.examples.size() < examples_per_key_) {
+            per_key.examples.push_back(message);
+            per_key.examples.back().source = source;
+        }
+    }
+
+} // acmacs::virus::v2::name::message_aggregator_t::add
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::message_aggregator_t::merge(const message_aggregator_t& other)
+{
+    total_ += other.total_;
+    for (const auto& [key, other_per_key] : other.keys_) {
+        auto& per_key = keys_[key];
+        per_key.count += other_per_key.count;
+        for (auto example = other_per_key.examples.begin(); example != other_per_key.examples.end() && per_key.examples.size() < examples_per_key_; ++example)
+            per_key.examples.push_back(*example);
+    }
+    for (const auto& [value, count] : other.values_)
+        count_value(value, count);
+    // errors of the two summaries add up
+    evicted_ += other.evicted_;
+
+} // acmacs::virus::v2::name::message_aggregator_t::merge
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::message_aggregator_t::count_value(const std::string& value, size_t count)
+{
+    if (const auto found = values_.find(value); found != values_.end()) {
+        values_by_count_.erase({found->second, value});
+        found->second += count;
+        values_by_count_.emplace(found->second, value);
+    }
+    else if (values_.size() < values_to_track_) {
+        values_.emplace(value, count);
+        values_by_count_.emplace(count, value);
+    }
+    else {
+        // space saving: replace the least frequent value, new value inherits its count
+        const auto least = values_by_count_.begin();
+        const auto least_count = least->first;
+        evicted_ = std::max(evicted_, least_count);
+        values_.erase(least->second);
+        values_by_count_.erase(least);
+        values_.emplace(value, least_count + count);
+        values_by_count_.emplace(least_count + count, value);
+    }
+
+} // acmacs::virus::v2::name::message_aggregator_t::count_value
+
+// ----------------------------------------------------------------------
+
+size_t acmacs::virus::v2::name::message_aggregator_t::count(std::string_view key) const
+{
+    if (const auto found = keys_.find(key); found != keys_.end())
+        return found->second.count;
+    else
+        return 0;
+
+} // acmacs::virus::v2::name::message_aggregator_t::count
+
+// ----------------------------------------------------------------------
+
+std::vector<std::pair<std::string, size_t>> acmacs::virus::v2::name::message_aggregator_t::top_values() const
+{
+    std::vector<std::pair<std::string, size_t>> result(values_.begin(), values_.end());
+    std::sort(result.begin(), result.end(), [](const auto& e1, const auto& e2) { return e1.second == e2.second ? e1.first < e2.first : e1.second > e2.second; });
+    if (result.size() > top_values_)
+        result.resize(top_values_);
+    return result;
+
+} // acmacs::virus::v2::name::message_aggregator_t::top_values
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::message_aggregator_t::report() const
+{
+    AD_INFO("Total messages: {}  keys: {}", total_, keys_.size());
+    for (const auto& [key, per_key] : keys_) {
+        if (key == acmacs::messages::key::location_not_found) {
+            const auto values = top_values();
+            AD_INFO("{} ({}) distinct values: {}{}", key, per_key.count, values_.size(), evicted_ ? fmt::format(" (more than tracked, counts may be overestimated by up to {})", evicted_) : std::string{});
+            for (const auto& [value, count] : values)
+                fmt::print(stderr, "    {:6d} {}\n", count, value);
+        }
+        else {
+            acmacs::messages::report(per_key.examples.begin(), per_key.examples.end());
+            if (per_key.count > per_key.examples.size())
+                fmt::print(stderr, "    ... and {} more \"{}\" messages\n", per_key.count - per_key.examples.size(), key);
+        }
+    }
+
+} // acmacs::virus::v2::name::message_aggregator_t::report
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::not_found_locations_t::add(std::string_view location, std::string_view raw_name)
+{
+    auto& shard = shards_[string_hash{}(location) % number_of_shards];
+    std::unique_lock lock{shard.access};
+    auto found = shard.entries.find(location);
+    if (found == shard.entries.end())
+        found = shard.entries.emplace(std::string{location}, entry_t{.location = std::string{location}}).first;
+    ++found->second.count;
+    if (found->second.examples.size() < examples_per_location_ && std::find(found->second.examples.begin(), found->second.examples.end(), raw_name) == found->second.examples.end())
+        found->second.examples.emplace_back(raw_name);
+
+} // acmacs::virus::v2::name::not_found_locations_t::add
+
+// ----------------------------------------------------------------------
+
+size_t acmacs::virus::v2::name::not_found_locations_t::size() const
+{
+    size_t result{0};
+    for (const auto& shard : shards_) {
+        std::unique_lock lock{shard.access};
+        result += shard.entries.size();
+    }
+    return result;
+
+} // acmacs::virus::v2::name::not_found_locations_t::size
+
+// ----------------------------------------------------------------------
+
+std::vector<acmacs::virus::v2::name::not_found_locations_t::entry_t> acmacs::virus::v2::name::not_found_locations_t::ranked() const
+{
+    std::vector<entry_t> result;
+    for (const auto& shard : shards_) {
+        std::unique_lock lock{shard.access};
+        for (const auto& [location, entry] : shard.entries)
+            result.push_back(entry);
+    }
+    std::sort(result.begin(), result.end(), [](const auto& e1, const auto& e2) { return e1.count == e2.count ? e1.location < e2.location : e1.count > e2.count; });
+    return result;
+
+} // acmacs::virus::v2::name::not_found_locations_t::ranked
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::not_found_locations_t::report() const
+{
+    const auto entries = ranked();
+    AD_INFO("Locations not found: {}", entries.size());
+    for (const auto& entry : entries) {
+        fmt::print(stderr, "    {:6d} \"{}\"\n", entry.count, entry.location);
+        for (const auto& example : entry.examples)
+            fmt::print(stderr, "               {}\n", example);
+    }
+
+} // acmacs::virus::v2::name::not_found_locations_t::report
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::interned_messages_t::add(message_key key, std::string_view key_s, std::string_view value, const acmacs::messages::position_t& source, const acmacs::messages::code_position_t& code)
+{
+    messages_.push_back(interned_message_t{.key = key,
+                                           .value = pool_.intern(value),
+                                           .other_key = key == message_key::other ? pool_.intern(key_s) : string_pool_t::id_t{0},
+                                           .source_filename = pool_.intern(source.filename),
+                                           .source_line_no = static_cast<uint32_t>(source.line_no),
+                                           .code = code});
+
+} // acmacs::virus::v2::name::interned_messages_t::add
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::interned_messages_t::add(const acmacs::messages::message_t& message)
+{
+    add(to_message_key(message.key), message.key, message.value, message.source, message.code);
+
+} // acmacs::virus::v2::name::interned_messages_t::add
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::interned_messages_t::add(const acmacs::messages::messages_t& messages)
+{
+    messages_.reserve(messages_.size() + messages.size());
+    for (const auto& message : messages)
+        add(message);
+
+} // acmacs::virus::v2::name::interned_messages_t::add
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::interned_messages_t::add(const acmacs::messages::messages_t& messages, const acmacs::messages::position_t& source)
+{
+    for (const auto& message : messages)
+        add(to_message_key(message.key), message.key, message.value, source, message.code);
+
+} // acmacs::virus::v2::name::interned_messages_t::add
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name::interned_messages_t::add(std::span<const lazy_message_t> messages, std::string_view raw, const acmacs::messages::position_t& source)
+{
+    for (const auto& message : messages)
+        add(message.key, to_string(message.key), message.text(raw), source, message.code);
+
+} // acmacs::virus::v2::name::interned_messages_t::add
+
+// ----------------------------------------------------------------------
+
+acmacs::messages::message_t acmacs::virus::v2::name::interned_messages_t::to_message(const interned_message_t& message) const
+{
+    return acmacs::messages::message_t{message.key == message_key::other ? pool_[message.other_key] : to_string(message.key), pool_[message.value],
+                                       acmacs::messages::position_t{pool_[message.source_filename], message.source_line_no}, message.code};
+
+} // acmacs::virus::v2::name::interned_messages_t::to_message
+
+// ----------------------------------------------------------------------
+
+acmacs::messages::messages_t acmacs::virus::v2::name::interned_messages_t::to_messages() const
+{
+    acmacs::messages::messages_t result;
+    result.reserve(messages_.size());
+    for (const auto& message : messages_)
+        result.push_back(to_message(message));
+    return result;
+
+} // acmacs::virus::v2::name::interned_messages_t::to_messages
+
+// ----------------------------------------------------------------------
+
 // void count_locations_to_check(acmacs::messages::iter_t first, acmacs::messages::iter_t last, acmacs::Counter<std::string>& locations_to_check)
 // {
 //     const auto add = [&locations_to_check](std::string_view part) {
@@ -2,9 +2,17 @@
 
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <mutex>
+#include <array>
+#include <vector>
+#include <span>
+#include <memory>
+#include <cstdint>
 
 #include "acmacs-base/fmt.hh"
 #include "acmacs-base/messages.hh"
+#include "acmacs-virus/string-pool.hh"
 
 // ----------------------------------------------------------------------
 
@@ -21,12 +29,303 @@ namespace acmacs::messages::inline v1::key
     constexpr static inline std::string_view unrecognized_passage{"unrecognized-passage"};
     constexpr static inline std::string_view reassortant_without_name{"reassortant-without-name"};
     constexpr static inline std::string_view location_or_host{"++location-or-host"};
+    constexpr static inline std::string_view multiple_location{"multiple-location"};
+    constexpr static inline std::string_view unexpected_location_part{"unexpected-location-part"};
+    constexpr static inline std::string_view double_location{"double-location"};
 } // namespace acmacs::messages::inline v1::key
 
 namespace acmacs::virus::inline v2::name
 {
+    // keys of messages produced by parse()
+    enum class message_key : uint8_t {
+        empty_name,
+        invalid_subtype,
+        invalid_host,
+        location_not_found,
+        location_field_not_found,
+        isolation_absent,
+        invalid_isolation,
+        invalid_year,
+        unrecognized_passage,
+        reassortant_without_name,
+        location_or_host,
+        multiple_location,
+        unexpected_location_part,
+        double_location,
+        unrecognized,
+        other, // key not made by parse(), e.g. in messages_t from elsewhere
+        size_  // number of keys
+    };
+
+    constexpr const size_t number_of_message_keys{static_cast<size_t>(message_key::size_)};
+
+    inline std::string_view to_string(message_key mkey)
+    {
+        using namespace acmacs::messages;
+        switch (mkey) {
+            case message_key::empty_name: return key::empty_name;
+            case message_key::invalid_subtype: return key::invalid_subtype;
+            case message_key::invalid_host: return key::invalid_host;
+            case message_key::location_not_found: return key::location_not_found;
+            case message_key::location_field_not_found: return key::location_field_not_found;
+            case message_key::isolation_absent: return key::isolation_absent;
+            case message_key::invalid_isolation: return key::invalid_isolation;
+            case message_key::invalid_year: return key::invalid_year;
+            case message_key::unrecognized_passage: return key::unrecognized_passage;
+            case message_key::reassortant_without_name: return key::reassortant_without_name;
+            case message_key::location_or_host: return key::location_or_host;
+            case message_key::multiple_location: return key::multiple_location;
+            case message_key::unexpected_location_part: return key::unexpected_location_part;
+            case message_key::double_location: return key::double_location;
+            case message_key::unrecognized: return key::unrecognized;
+            case message_key::other:
+            case message_key::size_: break;
+        }
+        return {};
+    }
+
+    inline message_key to_message_key(std::string_view key)
+    {
+        for (size_t key_no = 0; key_no < static_cast<size_t>(message_key::other); ++key_no) {
+            if (to_string(static_cast<message_key>(key_no)) == key)
+                return static_cast<message_key>(key_no);
+        }
+        return message_key::other;
+    }
+
+    // what parse() does with messages
+    //   none: no messages made
+    //   count: number of messages per key in parsed_fields_t::message_counts()
+    //   lazy: lazy_message_t in parsed_fields_t::lazy_messages(), parts of the raw name the message refers to are
+    //         kept as offsets, text is made on demand; text is made and copied only if they are not in the raw name
+    //   full: acmacs::messages::message_t in parsed_fields_t::messages
+    enum class message_policy { none, count, lazy, full };
+
+    using message_counts_t = std::array<size_t, number_of_message_keys>;
+
+    inline message_counts_t& operator+=(message_counts_t& target, const message_counts_t& source)
+    {
+        for (size_t no = 0; no < number_of_message_keys; ++no)
+            target[no] += source[no];
+        return target;
+    }
+
+    // how text of a message is made by make_message_text()
+    enum class message_format : uint8_t {
+        text,                   // refers_to
+        invalid_year,           // "\"<refers_to>\" <- \"<raw>\""
+        numbered_parts,         // "<numbers[0]> <parts>"
+        joined_parts,           // parts joined with slashes
+        location_parts,         // "{ <numbers>}"
+        location_parts_and_name // "{ <numbers>} \"<parts joined with slashes>\""
+    };
+
+    std::string make_message_text(message_format format, std::string_view refers_to, std::span<const uint32_t> numbers, std::span<const std::string_view> parts, std::string_view raw);
+
+    // message referring to the raw name (parsed_fields_t::raw), text is made on demand
+    struct lazy_message_t
+    {
+        struct slice_t
+        {
+            uint32_t offset; // in raw name
+            uint32_t length;
+        };
+
+        message_key key;
+        message_format format{message_format::text};
+        uint32_t offset{0}; // refers_to in raw name
+        uint32_t length{0};
+        std::vector<uint32_t> numbers{};
+        std::vector<slice_t> parts{};
+        std::string value{}; // text made when parsing, the message refers to text that is not in the raw name (e.g. reassortant in front removed), other fields are not used then
+        acmacs::messages::code_position_t code{};
+
+        std::string text(std::string_view raw) const;
+        acmacs::messages::message_t message(std::string_view raw) const { return acmacs::messages::message_t{to_string(key), text(raw), code}; }
+    };
+
+    using lazy_messages_t = std::vector<lazy_message_t>;
+
+    // Messages of message_policy::count and message_policy::lazy in
+    // parsed_fields_t, storage is allocated on the first message, i.e. only
+    // if one of these policies is used.
+    class policy_messages_t
+    {
+      public:
+        policy_messages_t() = default;
+        policy_messages_t(const policy_messages_t& source) : data_{source.data_ ? std::make_unique<data_t>(*source.data_) : nullptr} {}
+        policy_messages_t(policy_messages_t&&) noexcept = default;
+        policy_messages_t& operator=(const policy_messages_t& source)
+        {
+            if (this != &source)
+                data_ = source.data_ ? std::make_unique<data_t>(*source.data_) : nullptr;
+            return *this;
+        }
+        policy_messages_t& operator=(policy_messages_t&&) noexcept = default;
+
+        const message_counts_t& counts() const noexcept { return data_ ? data_->counts : no_counts; }
+        std::span<const lazy_message_t> lazy() const noexcept { return data_ ? std::span<const lazy_message_t>{data_->lazy} : std::span<const lazy_message_t>{}; }
+        size_t size() const noexcept;
+
+        void count(message_key key) { ++data().counts[static_cast<size_t>(key)]; }
+        void add(lazy_message_t&& message) { data().lazy.push_back(std::move(message)); }
+        void clear() noexcept; // storage is kept
+
+      private:
+        struct data_t
+        {
+            message_counts_t counts{};
+            lazy_messages_t lazy{};
+        };
+
+        static constexpr const message_counts_t no_counts{};
+        std::unique_ptr<data_t> data_{};
+
+        data_t& data()
+        {
+            if (!data_)
+                data_ = std::make_unique<data_t>();
+            return *data_;
+        }
+    };
+
     void report(acmacs::messages::messages_t& messages);
     void collect_not_found_locations(std::set<std::string>& locations, const acmacs::messages::messages_t& messages);
+
+    // ----------------------------------------------------------------------
+
+    // Keeps per key counts, a bounded number of example messages per key
+    // and (for location-not-found) top values with counts instead of all
+    // messages of a run. Not thread safe: use one aggregator per thread and
+    // merge them at the end.
+    class message_aggregator_t
+    {
+      public:
+        // values_to_track: number of distinct location-not-found values counted,
+        // when exceeded the least frequent value is replaced (space saving), reported counts may then be overestimated
+        message_aggregator_t(size_t examples_per_key = 10, size_t top_values = 100, size_t values_to_track = 1000)
+            : examples_per_key_{examples_per_key}, top_values_{top_values}, values_to_track_{std::max(values_to_track, top_values)}
+        {
+        }
+
+        void add(const acmacs::messages::message_t& message);
+        void add(const acmacs::messages::messages_t& messages, const acmacs::messages::position_t& source);
+        void merge(const message_aggregator_t& other);
+
+        size_t total() const { return total_; }
+        size_t count(std::string_view key) const;
+        std::vector<std::pair<std::string, size_t>> top_values() const; // location-not-found values, most frequent first
+        size_t max_overestimation() const { return evicted_; }         // counts of top_values() may be greater than real ones by up to that
+
+        // the same sections as name::report(messages_t&), messages beyond examples_per_key are counted only
+        void report() const;
+
+      private:
+        struct per_key_t
+        {
+            size_t count{0};
+            acmacs::messages::messages_t examples{};
+        };
+
+        size_t examples_per_key_;
+        size_t top_values_;
+        size_t values_to_track_;
+        size_t total_{0};
+        std::map<std::string, per_key_t, std::less<>> keys_{};
+        std::unordered_map<std::string, size_t> values_{};
+        std::set<std::pair<size_t, std::string>> values_by_count_{}; // the same as values_ ordered by count, the least frequent value is evicted in O(log n)
+        size_t evicted_{0}; // error bound: counts in values_ may be overestimated by that
+
+        per_key_t& count_message(const acmacs::messages::message_t& message);
+        void count_value(const std::string& value, size_t count);
+    };
+
+    // ----------------------------------------------------------------------
+
+    // Locations not found in locationdb, parse() reports into it directly
+    // (see parse(source, not_found_locations_t&, ...)). Thread safe, the
+    // same collector may be used by parsers in multiple threads.
+    class not_found_locations_t
+    {
+      public:
+        struct entry_t
+        {
+            std::string location;
+            size_t count{0};
+            std::vector<std::string> examples{}; // raw names
+        };
+
+        not_found_locations_t(size_t examples_per_location = 3) : examples_per_location_{examples_per_location} {}
+
+        void add(std::string_view location, std::string_view raw_name);
+        size_t size() const;
+        std::vector<entry_t> ranked() const; // most frequent first
+        void report() const;
+
+      private:
+        struct string_hash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+        };
+
+        struct shard_t
+        {
+            mutable std::mutex access{};
+            std::unordered_map<std::string, entry_t, string_hash, std::equal_to<>> entries{};
+        };
+
+        static constexpr const size_t number_of_shards{16};
+
+        size_t examples_per_location_;
+        std::array<shard_t, number_of_shards> shards_{};
+    };
+
+    // ----------------------------------------------------------------------
+
+    // message with key as enum and value and source filename as ids in string_pool_t
+    struct interned_message_t
+    {
+        message_key key;
+        string_pool_t::id_t value;
+        string_pool_t::id_t other_key; // key string for message_key::other
+        string_pool_t::id_t source_filename;
+        uint32_t source_line_no;
+        acmacs::messages::code_position_t code;
+    };
+
+    // Compact alternative to acmacs::messages::messages_t for big runs,
+    // duplicate values and source filenames are stored once in the pool,
+    // which may be shared by several containers (e.g. one per thread).
+    class interned_messages_t
+    {
+      public:
+        using const_iterator = std::vector<interned_message_t>::const_iterator;
+
+        interned_messages_t(string_pool_t& pool) : pool_{pool} {}
+        interned_messages_t(string_pool_t& pool, const acmacs::messages::messages_t& messages) : pool_{pool} { add(messages); }
+
+        void add(const acmacs::messages::message_t& message);
+        void add(const acmacs::messages::messages_t& messages);
+        void add(const acmacs::messages::messages_t& messages, const acmacs::messages::position_t& source); // like acmacs::messages::move_and_add_source()
+        void add(std::span<const lazy_message_t> messages, std::string_view raw, const acmacs::messages::position_t& source);
+
+        // source filenames of the result refer to the pool
+        acmacs::messages::messages_t to_messages() const;
+        acmacs::messages::message_t to_message(const interned_message_t& message) const;
+
+        size_t size() const { return messages_.size(); }
+        bool empty() const { return messages_.empty(); }
+        const_iterator begin() const { return messages_.begin(); }
+        const_iterator end() const { return messages_.end(); }
+        const string_pool_t& pool() const { return pool_; }
+
+      private:
+        string_pool_t& pool_;
+        std::vector<interned_message_t> messages_{};
+
+        void add(message_key key, std::string_view key_s, std::string_view value, const acmacs::messages::position_t& source, const acmacs::messages::code_position_t& code);
+    };
 }
 
 // ----------------------------------------------------------------------
@@ -92,6 +92,14 @@ struct processing_data_t
     std::vector<std::string> parts;
     std::string last_passage_type;
     std::string extra;
+
+    // capacities are kept
+    void clear()
+    {
+        parts.clear();
+        last_passage_type.clear();
+        extra.clear();
+    }
 };
 
 struct parsing_failed : public std::exception { using std::exception::exception; };
@@ -598,9 +606,10 @@ static const std::map<char, callback_t> normalize_data{
 
 // ----------------------------------------------------------------------
 
-acmacs::virus::parse_passage_t acmacs::virus::parse_passage(std::string_view source, passage_only po)
+// returns false if po == passage_only::yes and source is not just a passage
+static bool scan_passage(std::string_view source, acmacs::virus::passage_only po, processing_data_t& data)
 {
-    processing_data_t data;
+    using namespace acmacs::virus;
 
     AD_LOG(acmacs::log::passage_parsing, "src: \"{}\"", source);
     AD_LOG_INDENT;
@@ -628,7 +637,7 @@ acmacs::virus::parse_passage_t acmacs::virus::parse_passage(std::string_view sou
                 }
                 if (skip) {
                     if (po == passage_only::yes)
-                        return parse_passage_t{Passage{}, std::string{source}}; // parsing failed;
+                        return false; // parsing failed;
 
                     if (data.parts.empty()) { // passage not yet started
                         if (std::isalnum(*first)) {
@@ -654,6 +663,17 @@ acmacs::virus::parse_passage_t acmacs::virus::parse_passage(std::string_view sou
         AD_LOG(acmacs::log::passage_parsing, "src:\"{}\" passage:{} last_passage_type:{} extra:\"{}\"", std::string_view(&*first, static_cast<size_t>(source.end() - first)), data.parts,
                data.last_passage_type, data.extra);
     }
+    return true;
+
+} // scan_passage
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::parse_passage_t acmacs::virus::parse_passage(std::string_view source, passage_only po)
+{
+    processing_data_t data;
+    if (!scan_passage(source, po, data))
+        return parse_passage_t{Passage{}, std::string{source}}; // parsing failed;
 
     auto extra = ::string::upper(acmacs::string::strip(data.extra));
 
@@ -673,3 +693,36 @@ acmacs::virus::parse_passage_t acmacs::virus::parse_passage(std::string_view sou
 } // acmacs::virus::parse_passage
 
 // ----------------------------------------------------------------------
+
+bool acmacs::virus::is_good_passage(std::string_view source)
+{
+    thread_local processing_data_t data; // buffers are reused by subsequent calls in the thread
+    data.clear();
+    scan_passage(source, passage_only::no, data);
+    if (data.parts.empty()) // resulting passage would be empty
+        return false;
+    if (acmacs::string::strip(data.extra).empty())
+        return true;
+    // rare: extra may consist of words that parse_passage removes as redundant
+    return std::get<std::string>(parse_passage(source, passage_only::no)).empty();
+
+} // acmacs::virus::is_good_passage
+
+// ----------------------------------------------------------------------
+
+// compiles function local static regexes, called by acmacs::virus::init()
+namespace acmacs::virus::inline v2::detail
+{
+    void init_passage()
+    {
+        const Passage passage{"E1"};
+        passage.is_egg();
+        passage.is_cell();
+        passage.last_number();
+        passage.last_type();
+        parse_passage("E1", passage_only::no);
+    }
+
+} // namespace acmacs::virus::inline v2::detail
+
+// ----------------------------------------------------------------------
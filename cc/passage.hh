@@ -42,14 +42,18 @@ namespace acmacs::virus
         return p1.is_egg() == p2.is_egg();
     }
 
-    inline bool is_good_passage(std::string_view source)
-    {
-        const auto [passage, extra] = parse_passage(source, passage_only::no);
-        return !passage->empty() && extra.empty();
-    }
+    // same as checking result of parse_passage(source, passage_only::no) for non-empty passage and empty extra, but does not build the result
+    bool is_good_passage(std::string_view source);
 
     int passage_compare(const Passage& p1, const Passage& p2);
 
 } // namespace acmacs::virus
 
 // ----------------------------------------------------------------------
+
+template <> struct std::hash<acmacs::virus::Passage>
+{
+    size_t operator()(const acmacs::virus::Passage& passage) const noexcept { return std::hash<std::string_view>{}(*passage); }
+};
+
+// ----------------------------------------------------------------------
@@ -86,6 +86,15 @@ std::tuple<acmacs::virus::Reassortant, std::string> acmacs::virus::parse_reassor
 
 } // acmacs::virus::parse_reassortant
 
+// ----------------------------------------------------------------------
+
+// compiles function local static regexes, called by acmacs::virus::init()
+namespace acmacs::virus::inline v2::detail
+{
+    void init_reassortant() { parse_reassortant({}); }
+
+} // namespace acmacs::virus::inline v2::detail
+
 // ----------------------------------------------------------------------
 /// Local Variables:
 /// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
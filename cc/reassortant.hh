@@ -25,6 +25,11 @@ namespace acmacs
     inline std::string to_string(const acmacs::virus::Reassortant& reassortant) { return *reassortant; }
 }
 
+template <> struct std::hash<acmacs::virus::Reassortant>
+{
+    size_t operator()(const acmacs::virus::Reassortant& reassortant) const noexcept { return std::hash<std::string_view>{}(*reassortant); }
+};
+
 // ----------------------------------------------------------------------
 /// Local Variables:
 /// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
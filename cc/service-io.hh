@@ -0,0 +1,244 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "acmacs-base/fmt.hh"
+#include "acmacs-virus/virus.hh"
+
+// ----------------------------------------------------------------------
+// framed request/response i/o for virus-name-service and its test client
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::service
+{
+    enum class framing { newline, length_prefixed };
+
+    class fd_reader_t
+    {
+      public:
+        static constexpr const size_t default_max_frame_size{1 << 20};
+
+        fd_reader_t(int fd, framing a_framing, size_t max_frame_size = default_max_frame_size) : fd_{fd}, framing_{a_framing}, max_frame_size_{max_frame_size} {}
+
+        // returns std::nullopt on eof, error or frame larger than max_frame_size
+        std::optional<std::string> next()
+        {
+            while (true) {
+                if (auto frame = extract(); frame.has_value() || frame_too_large_)
+                    return frame;
+                if (!fill())
+                    return extract(true);
+            }
+        }
+
+        // reads available data once (blocks if there is none, non-blocking fd: returns true without reading), returns false on eof or error
+        bool fill()
+        {
+            std::array<char, 4096> data;
+            while (true) {
+                if (const auto bytes = ::read(fd_, data.data(), data.size()); bytes > 0) {
+                    buffer_.append(data.data(), static_cast<size_t>(bytes));
+                    return true;
+                }
+                else if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    return true;
+                else if (bytes == 0 || errno != EINTR)
+                    return false;
+            }
+        }
+
+        // next complete frame of the data read so far, at_eof: the last line without newline is returned too
+        std::optional<std::string> extract(bool at_eof = false)
+        {
+            if (frame_too_large_)
+                return std::nullopt;
+            switch (framing_) {
+                case framing::newline:
+                    if (const auto eol = buffer_.find('\n', scanned_); eol != std::string::npos) {
+                        std::string line{buffer_, 0, eol};
+                        buffer_.erase(0, eol + 1);
+                        scanned_ = 0;
+                        if (!line.empty() && line.back() == '\r')
+                            line.pop_back();
+                        return line;
+                    }
+                    scanned_ = buffer_.size();
+                    if (buffer_.size() > max_frame_size_)
+                        frame_too_large_ = true;
+                    else if (at_eof && !buffer_.empty()) {
+                        std::string line{std::move(buffer_)}; // last line without newline
+                        buffer_.clear();
+                        scanned_ = 0;
+                        return line;
+                    }
+                    break;
+                case framing::length_prefixed:
+                    if (buffer_.size() < 4)
+                        break;
+                    const size_t size = (static_cast<size_t>(static_cast<unsigned char>(buffer_[0])) << 24) | (static_cast<size_t>(static_cast<unsigned char>(buffer_[1])) << 16) |
+                                        (static_cast<size_t>(static_cast<unsigned char>(buffer_[2])) << 8) | static_cast<size_t>(static_cast<unsigned char>(buffer_[3]));
+                    if (size > max_frame_size_)
+                        frame_too_large_ = true;
+                    else if (buffer_.size() >= (size + 4)) {
+                        std::string frame{buffer_, 4, size};
+                        buffer_.erase(0, size + 4);
+                        return frame;
+                    }
+                    break;
+            }
+            return std::nullopt;
+        }
+
+        // peer sent frame (or line) larger than max_frame_size, nothing is read from it any more
+        bool frame_too_large() const { return frame_too_large_; }
+
+      private:
+        int fd_;
+        framing framing_;
+        size_t max_frame_size_;
+        std::string buffer_{};
+        size_t scanned_{0};
+        bool frame_too_large_{false};
+    };
+
+    // ----------------------------------------------------------------------
+
+    class fd_writer_t
+    {
+      public:
+        fd_writer_t(int fd, framing a_framing) : fd_{fd}, framing_{a_framing} {}
+
+        // blocking fd: writes frame, returns false on error (e.g. peer closed connection)
+        bool write(std::string_view data)
+        {
+            buffer_.clear();
+            append_frame(data);
+            for (size_t written = 0; written < buffer_.size();) {
+                if (const auto bytes = ::write(fd_, buffer_.data() + written, buffer_.size() - written); bytes >= 0)
+                    written += static_cast<size_t>(bytes);
+                else if (errno != EINTR)
+                    return false;
+            }
+            return true;
+        }
+
+        // non-blocking fd: frame is queued, it is written by flush() when fd is writable
+        void queue(std::string_view data)
+        {
+            if (written_ == buffer_.size()) {
+                buffer_.clear();
+                written_ = 0;
+            }
+            append_frame(data);
+        }
+
+        // writes queued frames until fd would block, returns false on error
+        bool flush()
+        {
+            while (written_ < buffer_.size()) {
+                if (const auto bytes = ::write(fd_, buffer_.data() + written_, buffer_.size() - written_); bytes >= 0)
+                    written_ += static_cast<size_t>(bytes);
+                else if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                else if (errno != EINTR)
+                    return false;
+            }
+            if (written_ > (buffer_.size() / 2)) { // drop written part, keep buffer from growing while peer is slow
+                buffer_.erase(0, written_);
+                written_ = 0;
+            }
+            return true;
+        }
+
+        // bytes queued and not yet written
+        size_t queued() const { return buffer_.size() - written_; }
+
+      private:
+        int fd_;
+        framing framing_;
+        std::string buffer_{};
+        size_t written_{0}; // part of buffer_ written by flush()
+
+        void append_frame(std::string_view data)
+        {
+            switch (framing_) {
+                case framing::newline:
+                    buffer_.append(data);
+                    buffer_.append(1, '\n');
+                    break;
+                case framing::length_prefixed:
+                    buffer_.append({static_cast<char>((data.size() >> 24) & 0xFF), static_cast<char>((data.size() >> 16) & 0xFF), static_cast<char>((data.size() >> 8) & 0xFF),
+                                    static_cast<char>(data.size() & 0xFF)});
+                    buffer_.append(data);
+                    break;
+            }
+        }
+    };
+
+    // ----------------------------------------------------------------------
+
+    // throws on error
+    inline void set_non_blocking(int fd)
+    {
+        if (const int flags = ::fcntl(fd, F_GETFL); flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+            throw Error{fmt::format("fcntl: {}", std::strerror(errno))};
+    }
+
+    // ----------------------------------------------------------------------
+
+    inline sockaddr_un socket_address(std::string_view socket_path)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path))
+            throw Error{fmt::format("socket path too long: {}", socket_path)};
+        std::copy(socket_path.begin(), socket_path.end(), address.sun_path);
+        return address;
+    }
+
+    // returns listening socket, throws on error
+    inline int listen(std::string_view socket_path)
+    {
+        const auto address = socket_address(socket_path);
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            throw Error{fmt::format("socket: {}", std::strerror(errno))};
+        ::unlink(address.sun_path); // remove stale socket
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+            const auto message = fmt::format("cannot listen on {}: {}", socket_path, std::strerror(errno));
+            ::close(fd);
+            throw Error{message};
+        }
+        return fd;
+    }
+
+    // returns connected socket, throws on error
+    inline int connect(std::string_view socket_path)
+    {
+        const auto address = socket_address(socket_path);
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            throw Error{fmt::format("socket: {}", std::strerror(errno))};
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+            const auto message = fmt::format("cannot connect to {}: {}", socket_path, std::strerror(errno));
+            ::close(fd);
+            throw Error{message};
+        }
+        return fd;
+    }
+
+} // namespace acmacs::virus::inline v2::service
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
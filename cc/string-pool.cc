@@ -0,0 +1,28 @@
+#include "acmacs-virus/string-pool.hh"
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::string_pool_t& acmacs::virus::interned_strings()
+{
+#include "acmacs-base/global-constructors-push.hh"
+    static string_pool_t pool;
+#include "acmacs-base/diagnostics-pop.hh"
+    return pool;
+
+} // acmacs::virus::interned_strings
+
+// ----------------------------------------------------------------------
+
+const std::string& acmacs::virus::interned_string_t::empty_string() noexcept
+{
+#include "acmacs-base/global-constructors-push.hh"
+    static const std::string empty;
+#include "acmacs-base/diagnostics-pop.hh"
+    return empty;
+
+} // acmacs::virus::interned_string_t::empty_string
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <compare>
+#include <cstdint>
+
+#include "acmacs-base/fmt.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2
+{
+    // Each distinct string is stored once and gets an id, ids are
+    // consecutive from 0 in the order of interning and stable for the
+    // lifetime of the pool, views returned by operator[] are stable too.
+    // Thread safe.
+    class string_pool_t
+    {
+      public:
+        using id_t = uint32_t;
+
+        string_pool_t() = default;
+        string_pool_t(const string_pool_t&) = delete;
+        string_pool_t& operator=(const string_pool_t&) = delete;
+
+        id_t intern(std::string_view str) { return intern_stored(str).first; }
+
+        // id and the stored string, which is stable for the lifetime of the pool
+        std::pair<id_t, const std::string*> intern_stored(std::string_view str)
+        {
+            {
+                std::shared_lock lock{access_};
+                if (const auto found = ids_.find(str); found != ids_.end())
+                    return {found->second, &strings_[found->second]};
+            }
+            std::unique_lock lock{access_};
+            if (const auto found = ids_.find(str); found != ids_.end()) // interned by another thread in the meantime
+                return {found->second, &strings_[found->second]};
+            const auto id = static_cast<id_t>(strings_.size());
+            const auto& stored = strings_.emplace_back(str); // deque does not move elements on emplace_back
+            ids_.emplace(std::string_view{stored}, id);
+            return {id, &stored};
+        }
+
+        // std::nullopt if not interned
+        std::optional<id_t> find(std::string_view str) const
+        {
+            std::shared_lock lock{access_};
+            if (const auto found = ids_.find(str); found != ids_.end())
+                return found->second;
+            return std::nullopt;
+        }
+
+        std::string_view operator[](id_t id) const
+        {
+            std::shared_lock lock{access_};
+            return strings_[id];
+        }
+
+        size_t size() const
+        {
+            std::shared_lock lock{access_};
+            return strings_.size();
+        }
+
+      private:
+        mutable std::shared_mutex access_{};
+        std::deque<std::string> strings_{};
+        std::unordered_map<std::string_view, id_t> ids_{};
+    };
+
+    // ----------------------------------------------------------------------
+
+    // Process-wide pool of locations, countries, continents and hosts of
+    // parse results, only values from bounded sets (locationdb, host list)
+    // are interned there. Strings are never removed.
+    string_pool_t& interned_strings();
+
+    // Handle of a string in interned_strings(): equal strings have equal
+    // handles, so comparison and hashing are by pointer, id() is the id in
+    // the pool. Empty string is not interned and has no id.
+    class interned_string_t
+    {
+      public:
+        interned_string_t() = default;
+        explicit interned_string_t(std::string_view str)
+        {
+            if (!str.empty())
+                std::tie(id_, str_) = interned_strings().intern_stored(str);
+        }
+
+        const std::string& operator*() const noexcept { return str_ != nullptr ? *str_ : empty_string(); }
+        const std::string* operator->() const noexcept { return &operator*(); }
+        operator std::string_view() const noexcept { return operator*(); }
+
+        bool empty() const noexcept { return str_ == nullptr; }
+        size_t size() const noexcept { return operator*().size(); }
+        char operator[](size_t pos) const noexcept { return operator*()[pos]; }
+        std::optional<string_pool_t::id_t> id() const noexcept { return str_ != nullptr ? std::optional{id_} : std::nullopt; }
+
+        bool operator==(const interned_string_t& rhs) const noexcept { return str_ == rhs.str_; }
+        bool operator==(std::string_view rhs) const noexcept { return std::string_view{operator*()} == rhs; }
+        bool operator==(const char* rhs) const noexcept { return std::string_view{operator*()} == rhs; }
+        std::strong_ordering operator<=>(const interned_string_t& rhs) const noexcept { return str_ == rhs.str_ ? std::strong_ordering::equal : operator*() <=> *rhs; }
+
+      private:
+        const std::string* str_{nullptr};
+        string_pool_t::id_t id_{0};
+
+        static const std::string& empty_string() noexcept;
+    };
+
+    // ----------------------------------------------------------------------
+
+    // Either interned_string_t (value from a bounded set, e.g. location
+    // found in locationdb) or plain string (e.g. location not found in
+    // locationdb), the latter is not put into interned_strings() to keep
+    // the pool bounded. Interned values are compared and hashed by
+    // pointer, plain ones by content, interned and plain values are never
+    // equal.
+    class maybe_interned_string_t
+    {
+      public:
+        maybe_interned_string_t() = default;
+        maybe_interned_string_t(interned_string_t interned) : interned_{interned} {}
+        explicit maybe_interned_string_t(std::string plain) : plain_{std::move(plain)} {}
+
+        maybe_interned_string_t& operator=(interned_string_t interned) noexcept
+        {
+            interned_ = interned;
+            plain_.clear();
+            return *this;
+        }
+
+        // capacity of the previous plain value is reused
+        void assign_plain(std::string_view plain)
+        {
+            interned_ = interned_string_t{};
+            plain_.assign(plain);
+        }
+
+        void clear() noexcept
+        {
+            interned_ = interned_string_t{};
+            plain_.clear();
+        }
+
+        const std::string& operator*() const noexcept { return interned_.empty() ? plain_ : *interned_; }
+        const std::string* operator->() const noexcept { return &operator*(); }
+        operator std::string_view() const noexcept { return operator*(); }
+
+        bool empty() const noexcept { return interned_.empty() && plain_.empty(); }
+        size_t size() const noexcept { return operator*().size(); }
+        char operator[](size_t pos) const noexcept { return operator*()[pos]; }
+        bool is_interned() const noexcept { return !interned_.empty(); }
+        const interned_string_t& interned() const noexcept { return interned_; } // empty for a plain value
+
+        bool operator==(const maybe_interned_string_t& rhs) const noexcept { return interned_ == rhs.interned_ && (is_interned() || plain_ == rhs.plain_); }
+        bool operator==(const interned_string_t& rhs) const noexcept { return interned_ == rhs && (is_interned() || plain_.empty()); }
+        bool operator==(std::string_view rhs) const noexcept { return std::string_view{operator*()} == rhs; }
+        bool operator==(const char* rhs) const noexcept { return std::string_view{operator*()} == rhs; }
+        std::strong_ordering operator<=>(const maybe_interned_string_t& rhs) const noexcept
+        {
+            if (operator==(rhs))
+                return std::strong_ordering::equal;
+            if (const auto cmp = operator*() <=> *rhs; cmp != 0)
+                return cmp;
+            return rhs.is_interned() <=> is_interned(); // same content: interned first
+        }
+
+      private:
+        interned_string_t interned_{};
+        std::string plain_{};
+    };
+
+} // namespace acmacs::virus::inline v2
+
+template <> struct std::hash<acmacs::virus::interned_string_t>
+{
+    size_t operator()(const acmacs::virus::interned_string_t& str) const noexcept { return std::hash<const std::string*>{}(str.empty() ? nullptr : &*str); }
+};
+
+template <> struct std::hash<acmacs::virus::maybe_interned_string_t>
+{
+    size_t operator()(const acmacs::virus::maybe_interned_string_t& str) const noexcept
+    {
+        return str.is_interned() ? std::hash<acmacs::virus::interned_string_t>{}(str.interned()) : std::hash<std::string_view>{}(*str);
+    }
+};
+
+template <> struct fmt::formatter<acmacs::virus::interned_string_t> : public fmt::formatter<std::string_view>
+{
+    template <typename FormatContext> auto format(const acmacs::virus::interned_string_t& str, FormatContext& ctx) { return fmt::formatter<std::string_view>::format(*str, ctx); }
+};
+
+template <> struct fmt::formatter<acmacs::virus::maybe_interned_string_t> : public fmt::formatter<std::string_view>
+{
+    template <typename FormatContext> auto format(const acmacs::virus::maybe_interned_string_t& str, FormatContext& ctx) { return fmt::formatter<std::string_view>::format(*str, ctx); }
+};
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -148,6 +148,10 @@ void test_builtin()
                            field_mistmatch_output(std::get<std::string>(result), std::get<std::string>(entry.expected)));
                 ++errors;
             }
+            if (const auto good = !std::get<Passage>(result).empty() && std::get<std::string>(result).empty(); is_good_passage(entry.raw_passage) != good) {
+                fmt::print(stderr, "SRC: \"{}\"\nis_good_passage: {}, parse_passage: {}\n\n", entry.raw_passage, !good, good);
+                ++errors;
+            }
         }
         catch (std::exception& err) {
             fmt::print(stderr, "SRC: {}\nERR: {}", entry.raw_passage, err);
@@ -0,0 +1,430 @@
+#include <array>
+#include <regex>
+#include <chrono>
+#include <algorithm>
+#include <cctype>
+
+#include "acmacs-base/fmt.hh"
+#include "acmacs-base/read-file.hh"
+#include "acmacs-base/string-split.hh"
+#include "acmacs-base/string-strip.hh"
+#include "acmacs-virus/virus-name-v1.hh"
+#include "acmacs-virus/full-name-index.hh"
+
+// ----------------------------------------------------------------------
+// Compares virus_name v1 functions with their former std::regex
+// implementation (kept below as the reference) over builtin names or over
+// names read from files (one per line). Checks full_name_index_t lookups
+// against extracting name part of each full name. For files time spent by
+// both implementations and by the index lookups is reported.
+// ----------------------------------------------------------------------
+
+static size_t test_names(const std::vector<std::string_view>& names);
+static size_t test_full_name_index(const std::vector<std::string_view>& names);
+static void benchmark(const std::vector<std::string_view>& names);
+static void benchmark_full_name_index(const std::vector<std::string_view>& names);
+
+// ----------------------------------------------------------------------
+
+int main(int argc, const char* const* argv)
+{
+    int exit_code = 0;
+    try {
+        std::vector<std::string> file_data;
+        std::vector<std::string_view> names;
+        if (argc > 1) {
+            for (int arg = 1; arg < argc; ++arg) {
+                file_data.push_back(acmacs::file::read(argv[arg]));
+                for (const auto& name : acmacs::string::split(file_data.back(), "\n", acmacs::string::Split::RemoveEmpty))
+                    names.push_back(name);
+            }
+        }
+        else {
+            names = {
+                "A/SINGAPORE/INFIMH-16-0019/2016",
+                "A/SINGAPORE/INFIMH-16-0019/16",
+                "A(H3N2)/SINGAPORE/INFIMH-16-0019/2016 MDCK1",
+                "A(H3N2)/SINGAPORE/INFIMH-16-0019/2016  SIAT2/SIAT1",
+                "A(H3N2)/SINGAPORE/INFIMH-16-0019/2016__MDCK1",
+                "A/SINGAPORE/INFIMH-16-0019/2016 CL2  X-307A",
+                "A/SINGAPORE/INFIMH-16-0019/2016 X-307A E5",
+                "A/SINGAPORE/INFIMH-16-0019/2016 NYMC-307A E5",
+                "A/SINGAPORE/INFIMH-16-0019/2016 X-307A MDCK1",
+                "B/PHUKET/3073/2013 BVR-1B",
+                "A/duck/Guangdong/4.30 DGCPLB014-O/2017",
+                "A/Snowy Sheathbill/Antarctica/2899/2014",
+                "A/chicken/Yunnan/Kunming/2007",
+                "A/Algeria/G0281/16/2016",
+                "A/Lyon/CHU/R18.54.48/2018",
+                "A/TOKYO/UT-IMS2-1/2014_HY-PR8-HA-N121K",
+                "A/TOKYO/UT-IMS2-1/2014-HY",
+                "A/CALIFORNIA/07/2009 )",
+                "A/CALIFORNIA/07/2009 ) E5",
+                "A/CALIFORNIA/07/2009)E5",
+                "A/CALIFORNIA/000/2009",
+                "A/CALIFORNIA/7/1999",
+                "A/CALIFORNIA/7/99",
+                "A/CALIFORNIA/7/19",
+                "A/CALIFORNIA/7/209",
+                "A/CALIFORNIA/7/2009x",
+                "A/CALIFORNIA/7/2009 ",
+                "A(H1)//ARGENTINA/FLE0116/2009",
+                "A/PTO MONTT75856/2015",
+                "A/X/1/2016",
+                "B/AB/1/2016",
+                "AB/CD/1/2016",
+                "//CD/1/2016",
+                "IVR-153 (A/CALIFORNIA/07/2009)",
+                "MD-ABC E2",
+                "NY-1234 MDCK2",
+                "GA 1234 SIAT1",
+                "ABC DEF X?",
+                "UNRECOGNIZED",
+                "",
+            };
+        }
+        if (const auto errors = test_names(names); errors)
+            throw std::runtime_error{fmt::format("{} differences in {} names", errors, names.size())};
+        if (const auto errors = test_full_name_index(names); errors)
+            throw std::runtime_error{fmt::format("{} full_name_index_t lookup errors", errors)};
+        if (argc > 1) {
+            benchmark(names);
+            benchmark_full_name_index(names);
+        }
+    }
+    catch (std::exception& err) {
+        fmt::print(stderr, "ERROR: {}\n", err);
+        exit_code = 1;
+    }
+    return exit_code;
+}
+
+// ----------------------------------------------------------------------
+
+namespace reference
+{
+    using namespace virus_name;
+
+#include "acmacs-base/global-constructors-push.hh"
+    const std::regex cdc_name{"^([A-Z][A-Z][A-Z]?)[ \\-]"};
+    constexpr const char* re_international_name = "^(?:([AB][^/]*)/)?(?:([^/]+)/)?([^/]{2,})/0*([^/]+)/(19|20)?(\\d\\d)(?:\\s*\\)\\s*)?";
+    const std::regex international{std::string(re_international_name) + "(?:(?:\\s+|__)(.+))?$"};
+    const std::regex international_name{re_international_name};
+    const std::regex international_name_with_extra{std::string(re_international_name) + "(?:[\\s_\\-]*(.+))?"};
+    const std::regex passage_after_name{" (MDCK|SIAT|MK|E|X)[X\\?\\d]"};
+#include "acmacs-base/diagnostics-pop.hh"
+
+    inline std::string make_year(const std::cmatch& m)
+    {
+        if (m[5].length())
+            return m[5].str() + m[6].str();
+        else if (m[6].str()[0] > '2')
+            return "19" + m[6].str();
+        else
+            return "20" + m[6].str();
+    }
+
+    inline std::string_view name(std::string_view aFullName)
+    {
+        std::cmatch m;
+        if (std::regex_search(aFullName.begin(), aFullName.end(), m, international_name))
+            return aFullName.substr(0, static_cast<size_t>(m.length()));
+        else if (std::regex_search(aFullName.begin(), aFullName.end(), m, passage_after_name))
+            return aFullName.substr(0, static_cast<size_t>(m.position()));
+        else
+            return aFullName;
+    }
+
+    inline std::string location_for_cdc_name(std::string_view name)
+    {
+        std::cmatch m;
+        if (std::regex_search(std::begin(name), std::end(name), m, cdc_name))
+            return "#" + m[1].str();
+        throw Unrecognized{fmt::format("No cdc abbreviation in {}", name)};
+    }
+
+    inline std::string location(std::string_view name, prioritize_cdc_name check_cdc_first)
+    {
+        try {
+            if (check_cdc_first == prioritize_cdc_name::yes)
+                return location_for_cdc_name(name);
+        }
+        catch (Unrecognized&) {
+        }
+        std::cmatch m;
+        if (std::regex_search(std::begin(name), std::end(name), m, international_name))
+            return m[3].str();
+        try {
+            if (check_cdc_first == prioritize_cdc_name::no)
+                return location_for_cdc_name(name);
+        }
+        catch (Unrecognized&) {
+        }
+        throw Unrecognized{fmt::format("No location in \"{}\"", name)};
+    }
+
+    inline std::string_view virus_type(std::string_view name)
+    {
+        std::cmatch m;
+        if (std::regex_search(std::begin(name), std::end(name), m, international_name))
+            return {name.data() + m.position(1), static_cast<size_t>(m.length(1))};
+        throw Unrecognized(fmt::format("No virus_type in {}", name));
+    }
+
+    inline void split(std::string_view name, std::string& virus_type, std::string& host, std::string& location, std::string& isolation, std::string& year, std::string& passage)
+    {
+        std::cmatch m;
+        if (std::regex_match(std::begin(name), std::end(name), m, international)) {
+            virus_type = m[1].str();
+            host = m[2].str();
+            location = m[3].str();
+            isolation = m[4].str();
+            year = make_year(m);
+            passage = m[7].str();
+        }
+        else
+            throw Unrecognized(fmt::format("Cannot split {}", name));
+    }
+
+    inline void split_with_extra(std::string_view name, std::string& virus_type, std::string& host, std::string& location, std::string& isolation, std::string& year, std::string& passage, std::string& extra)
+    {
+        try {
+            split(name, virus_type, host, location, isolation, year, passage);
+        }
+        catch (Unrecognized&) {
+            std::cmatch m;
+            if (std::regex_search(std::begin(name), std::end(name), m, international_name_with_extra)) {
+                virus_type = m[1].str();
+                host = m[2].str();
+                location = m[3].str();
+                isolation = m[4].str();
+                year = make_year(m);
+                extra = acmacs::string::join(acmacs::string::join_space, m.prefix().str(), m[7].str());
+            }
+            else
+                throw Unrecognized(fmt::format("Cannot split {}", name));
+        }
+    }
+
+    // fields of virus_name::Name
+    inline std::string name_fields(std::string_view source)
+    {
+        const auto split_and_strip = [](std::string_view name) {
+            std::cmatch m;
+            if (std::regex_search(std::begin(name), std::end(name), m, international_name_with_extra)) {
+                auto isolation = acmacs::string::strip(m[4].str());
+                if (const auto first_not_zero = isolation.find_first_not_of('0'); first_not_zero != std::string::npos)
+                    isolation.erase(0, first_not_zero);
+                return fmt::format("{}|{}|{}|{}|{}|{}", acmacs::string::strip(m[1].str()), acmacs::string::strip(m[2].str()), acmacs::string::strip(m[3].str()), isolation, make_year(m),
+                                   acmacs::string::join(acmacs::string::join_space, acmacs::string::strip(m.prefix().str()), acmacs::string::strip(m[7].str())));
+            }
+            throw Unrecognized(fmt::format("Cannot split {}", name));
+        };
+
+        try {
+            return split_and_strip(source);
+        }
+        catch (Unrecognized&) {
+            if (std::count(std::begin(source), std::end(source), '/') == 2) {
+                if (const auto num_start = std::find_if(std::begin(source), std::end(source), [](char cc) { return std::isdigit(cc); });
+                    num_start != std::begin(source) && num_start != std::end(source) && *(num_start - 1) != '/') {
+                    std::string new_source{source};
+                    new_source.insert(static_cast<size_t>(num_start - std::begin(source)), 1, '/');
+                    return split_and_strip(new_source);
+                }
+            }
+            throw;
+        }
+    }
+
+} // namespace reference
+
+// ----------------------------------------------------------------------
+
+struct reference_api
+{
+    static constexpr auto name = &reference::name;
+    static constexpr auto location = &reference::location;
+    static constexpr auto virus_type = &reference::virus_type;
+    static constexpr auto split = &reference::split;
+    static constexpr auto split_with_extra = &reference::split_with_extra;
+    static constexpr auto name_fields = &reference::name_fields;
+};
+
+struct current_api
+{
+    static constexpr auto name = &virus_name::name;
+    static constexpr auto location = &virus_name::location;
+    static constexpr auto virus_type = &virus_name::virus_type;
+    static constexpr auto split = &virus_name::split;
+    static constexpr auto split_with_extra = &virus_name::split_with_extra;
+    static std::string name_fields(std::string_view source)
+    {
+        const virus_name::Name name{source};
+        return fmt::format("{}|{}|{}|{}|{}|{}", name.virus_type, name.host, name.location, name.isolation, name.year, name.extra);
+    }
+};
+
+constexpr std::array v1_functions{"name", "location", "location(cdc first)", "virus_type", "split", "split_with_extra", "Name"};
+
+// results of all v1 functions for the name, exceptions are reported as "<unrecognized>"
+template <typename Api> std::array<std::string, v1_functions.size()> v1_results(std::string_view source)
+{
+    const auto outcome = [](auto&& func) -> std::string {
+        try {
+            return func();
+        }
+        catch (virus_name::Unrecognized&) {
+            return "<unrecognized>";
+        }
+    };
+
+    return {
+        std::string{Api::name(source)},
+        outcome([source] { return Api::location(source, virus_name::prioritize_cdc_name::no); }),
+        outcome([source] { return Api::location(source, virus_name::prioritize_cdc_name::yes); }),
+        outcome([source] { return std::string{Api::virus_type(source)}; }),
+        outcome([source] {
+            std::string virus_type, host, location, isolation, year, passage;
+            Api::split(source, virus_type, host, location, isolation, year, passage);
+            return fmt::format("{}|{}|{}|{}|{}|{}", virus_type, host, location, isolation, year, passage);
+        }),
+        outcome([source] {
+            std::string virus_type, host, location, isolation, year, passage, extra;
+            Api::split_with_extra(source, virus_type, host, location, isolation, year, passage, extra);
+            return fmt::format("{}|{}|{}|{}|{}|{}|{}", virus_type, host, location, isolation, year, passage, extra);
+        }),
+        outcome([source] { return Api::name_fields(source); }),
+    };
+}
+
+// ----------------------------------------------------------------------
+
+size_t test_names(const std::vector<std::string_view>& names)
+{
+    size_t errors = 0;
+    for (const auto& name : names) {
+        const auto expected = v1_results<reference_api>(name);
+        const auto result = v1_results<current_api>(name);
+        for (size_t no = 0; no < v1_functions.size(); ++no) {
+            if (result[no] != expected[no]) {
+                fmt::print(stderr, "ERROR: {} \"{}\"\n    regex:    \"{}\"\n    matcher:  \"{}\"\n", v1_functions[no], name, expected[no], result[no]);
+                ++errors;
+            }
+        }
+    }
+    return errors;
+
+} // test_names
+
+// ----------------------------------------------------------------------
+
+void benchmark(const std::vector<std::string_view>& names)
+{
+    using clock_t = std::chrono::steady_clock;
+    const auto measure = [&names](auto&& func) {
+        const auto start = clock_t::now();
+        for (const auto& name : names) {
+            try {
+                func(name);
+            }
+            catch (virus_name::Unrecognized&) {
+            }
+        }
+        return std::chrono::duration<double>(clock_t::now() - start).count();
+    };
+    const auto report = [&names](std::string_view function, double regex, double matcher) {
+        fmt::print("{:<18s} regex: {:8.3f}s  matcher: {:8.3f}s  {:6.1f}x  ({} names)\n", function, regex, matcher, matcher > 0.0 ? regex / matcher : 0.0, names.size());
+    };
+
+    report("name", measure([](std::string_view name) { return reference::name(name); }), measure([](std::string_view name) { return virus_name::name(name); }));
+    report("location", measure([](std::string_view name) { return reference::location(name, virus_name::prioritize_cdc_name::no); }),
+           measure([](std::string_view name) { return virus_name::location(name); }));
+    report("virus_type", measure([](std::string_view name) { return reference::virus_type(name); }), measure([](std::string_view name) { return virus_name::virus_type(name); }));
+    std::string virus_type, host, location, isolation, year, passage, extra;
+    report("split", measure([&](std::string_view name) { reference::split(name, virus_type, host, location, isolation, year, passage); }),
+           measure([&](std::string_view name) { virus_name::split(name, virus_type, host, location, isolation, year, passage); }));
+    report("split_with_extra", measure([&](std::string_view name) { reference::split_with_extra(name, virus_type, host, location, isolation, year, passage, extra); }),
+           measure([&](std::string_view name) { virus_name::split_with_extra(name, virus_type, host, location, isolation, year, passage, extra); }));
+
+} // benchmark
+
+size_t test_full_name_index(const std::vector<std::string_view>& names)
+{
+    using namespace acmacs::virus;
+    const full_name_index_t index(names.begin(), names.end());
+    std::vector<std::string> name_parts(names.size());
+    std::transform(names.begin(), names.end(), name_parts.begin(), [](std::string_view full_name) { return full_name_index_t::normalize(reference::name(full_name)); });
+    const auto same_entry = [](const full_name_index_t::entry_t& e1, const full_name_index_t::entry_t& e2) {
+        return e1.name == e2.name && e1.reassortant == e2.reassortant && e1.passage == e2.passage && e1.extra == e2.extra;
+    };
+
+    size_t errors = 0;
+    for (size_t no = 0; no < std::min(names.size(), size_t{1000}); ++no) {
+        // linear scan, as find_by_full_name does
+        full_name_index_t::indexes_t same_name;
+        std::optional<full_name_index_t::index_t> same_full_name;
+        const auto entry = full_name_index_t::split(names[no]);
+        for (size_t other = 0; other < names.size(); ++other) {
+            if (name_parts[other] == name_parts[no])
+                same_name.push_back(other);
+            if (!same_full_name.has_value() && same_entry(index[other], entry))
+                same_full_name = other;
+        }
+        if (const auto& found = index.find_by_name(names[no]); found != same_name) {
+            fmt::print(stderr, "ERROR: full_name_index_t::find_by_name \"{}\": {} expected {}\n", names[no], found, same_name);
+            ++errors;
+        }
+        if (const auto found = index.find(names[no]); found != same_full_name || found > no) {
+            fmt::print(stderr, "ERROR: full_name_index_t::find \"{}\": {} expected {}\n", names[no], found.value_or(names.size()), same_full_name.value_or(names.size()));
+            ++errors;
+        }
+    }
+    return errors;
+
+} // test_full_name_index
+
+// ----------------------------------------------------------------------
+
+void benchmark_full_name_index(const std::vector<std::string_view>& names)
+{
+    using clock_t = std::chrono::steady_clock;
+    const auto per_query = [](const std::chrono::duration<double>& elapsed, size_t queries) { return elapsed.count() * 1e6 / static_cast<double>(queries); };
+
+    // find_by_full_name without index: extract name part of every full name for each query
+    const size_t scan_queries = std::min(names.size(), size_t{100});
+    auto start = clock_t::now();
+    for (size_t query = 0; query < scan_queries; ++query) {
+        const auto name = reference::name(names[query]);
+        if (std::none_of(names.begin(), names.end(), [name](std::string_view full_name) { return reference::name(full_name) == name; }))
+            throw std::runtime_error{"benchmark_full_name_index: name not found by scan"};
+    }
+    const std::chrono::duration<double> scan = clock_t::now() - start;
+
+    start = clock_t::now();
+    const acmacs::virus::full_name_index_t index(names.begin(), names.end());
+    const std::chrono::duration<double> build = clock_t::now() - start;
+
+    start = clock_t::now();
+    for (const auto& name : names) {
+        if (index.find_by_name(name).empty())
+            throw std::runtime_error{"benchmark_full_name_index: name not found by index"};
+    }
+    const std::chrono::duration<double> lookup_by_name = clock_t::now() - start;
+
+    start = clock_t::now();
+    for (const auto& name : names) {
+        if (!index.find(name).has_value())
+            throw std::runtime_error{"benchmark_full_name_index: full name not found by index"};
+    }
+    const std::chrono::duration<double> lookup = clock_t::now() - start;
+
+    fmt::print("full_name_index_t  {} names  regex scan: {:10.1f}us/query  index build: {:8.3f}s  find_by_name: {:6.3f}us/query  find: {:6.3f}us/query\n", names.size(), per_query(scan, scan_queries),
+               build.count(), per_query(lookup_by_name, names.size()), per_query(lookup, names.size()));
+
+} // benchmark_full_name_index
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -1,11 +1,59 @@
 #include <array>
+#include <algorithm>
 #include <tuple>
+#include <filesystem>
+#include <random>
+#include <numeric>
+#include <unordered_set>
+#include <chrono>
+#include <new>
+#include <cstdlib>
+#include <unistd.h>
 
 #include "acmacs-base/log.hh"
+#include "acmacs-base/read-file.hh"
+#include "acmacs-base/string-split.hh"
+#include "acmacs-base/string-join.hh"
+#include "acmacs-base/string-from-chars.hh"
+#include "acmacs-virus/log.hh"
 #include "acmacs-virus/virus-name-normalize.hh"
+#include "acmacs-virus/name-dictionary.hh"
+#include "acmacs-virus/bitmap-index.hh"
+#include "acmacs-virus/name-sort.hh"
+#include "acmacs-virus/location-fuzzy-index.hh"
+#include "acmacs-virus/name-matcher.hh"
 
 static void test_from_command_line(int argc, const char* const* argv);
 static void test_builtin();
+static size_t test_projections(std::string_view raw_name, const acmacs::virus::name::parsed_fields_t& full);
+static size_t test_message_policies(std::string_view raw_name, const acmacs::virus::name::parsed_fields_t& full);
+static size_t test_name_dictionary(std::span<const acmacs::virus::name_t> names);
+static size_t test_bitmap_index(const acmacs::virus::name::parsed_columns_t& columns);
+static size_t test_sort(std::vector<acmacs::virus::name::parsed_fields_t> fields);
+static size_t test_fuzzy_location_index();
+static size_t test_message_aggregator();
+static size_t test_name_matcher();
+static size_t test_parse_into_allocations();
+static void test_match_benchmark(size_t size);
+static bool diverges(const acmacs::virus::name::parsed_fields_t& single_pass, const acmacs::virus::name::parsed_fields_t& reference);
+static std::string_view known_single_pass_divergence(std::string_view raw_name);
+static void test_differential(int argc, const char* const* argv);
+
+// ----------------------------------------------------------------------
+
+// allocations made by this thread, see test_parse_into_allocations()
+static thread_local size_t allocations{0};
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size); ptr != nullptr)
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
 
 // ----------------------------------------------------------------------
 
@@ -13,7 +61,11 @@ int main(int argc, const char* const* argv)
 {
     int exit_code = 0;
     try {
-        if (argc > 1)
+        if (argc > 2 && std::string_view{argv[1]} == "--diff")
+            test_differential(argc - 2, argv + 2);
+        else if (argc > 1 && std::string_view{argv[1]} == "--match-benchmark")
+            test_match_benchmark(argc > 2 ? acmacs::string::from_chars<size_t>(argv[2]) : 100000);
+        else if (argc > 1)
             test_from_command_line(argc, argv);
         else
             test_builtin();
@@ -48,7 +100,7 @@ struct to_compare_t
 
 inline auto operator==(const acmacs::virus::name::parsed_fields_t& parsed, const to_compare_t& expected)
 {
-    return parsed.subtype == expected.subtype && parsed.host == expected.host && parsed.location == expected.location && parsed.isolation == expected.isolation && parsed.year == expected.year &&
+    return parsed.subtype == expected.subtype && parsed.host == *expected.host && parsed.location == expected.location && parsed.isolation == expected.isolation && parsed.year == expected.year &&
            parsed.reassortant == expected.reassortant && parsed.passage == expected.passage && parsed.extra == expected.extra;
 }
 inline auto operator!=(const acmacs::virus::name::parsed_fields_t& parsed, const to_compare_t& expected) { return !operator==(parsed, expected); }
@@ -154,6 +206,10 @@ void test_builtin()
     };
 
     size_t errors = 0;
+    acmacs::messages::messages_t all_messages;
+    std::array<acmacs::virus::name::message_aggregator_t, 2> aggregators; // as if names were parsed in two threads
+    size_t single_pass_divergent{0};
+    acmacs::virus::name::not_found_locations_t not_found_locations;
     for (const auto& entry : data) {
         try {
             // AD_DEBUG("{}", entry.raw_name);
@@ -166,6 +222,27 @@ void test_builtin()
                 acmacs::messages::report_by_type(result.messages);
                 AD_INFO("{}", result);
             }
+            errors += test_projections(entry.raw_name, result);
+            errors += test_message_policies(entry.raw_name, result);
+            if (acmacs::virus::name::is_good(entry.raw_name) != result.good()) {
+                AD_ERROR("is_good() disagrees with parse().good() ({}) <-- \"{}\"", result.good(), entry.raw_name);
+                ++errors;
+            }
+            aggregators[all_messages.size() % aggregators.size()].add(result.messages, acmacs::messages::position_t{});
+            acmacs::virus::name::parse(entry.raw_name, not_found_locations, acmacs::virus::name::parse_fields::all, acmacs::virus::name::message_policy::none);
+            if (const auto single_pass = acmacs::virus::name::parse_single_pass(entry.raw_name); diverges(single_pass, result)) {
+                if (const auto reason = known_single_pass_divergence(entry.raw_name); !reason.empty()) {
+                    AD_LOG(acmacs::log::name_parsing, "single pass ({}): {}\n    parse: {}\n    <-- \"{}\"", reason, single_pass, result, entry.raw_name);
+                    ++single_pass_divergent;
+                }
+                else {
+                    AD_ERROR("parse_single_pass() diverges from parse()\n    single pass: {}\n    parse: {}\n    <-- \"{}\"", single_pass, result, entry.raw_name);
+                    ++errors;
+                }
+            }
+            else if (!known_single_pass_divergence(entry.raw_name).empty())
+                AD_WARNING("parse_single_pass() agrees with parse(), remove from known divergences: \"{}\"", entry.raw_name);
+            all_messages.insert(all_messages.end(), result.messages.begin(), result.messages.end());
         }
         catch (std::exception& err) {
             AD_ERROR("SRC: {}: {}", entry.raw_name, err);
@@ -173,6 +250,148 @@ void test_builtin()
         }
     }
 
+    AD_INFO("parse_single_pass() diverges from parse() for {} of {} names, all known", single_pass_divergent, data.size());
+
+    std::vector<std::string_view> batch(data.size());
+    std::transform(data.begin(), data.end(), batch.begin(), [](const auto& entry) { return std::string_view{entry.raw_name}; });
+    const auto batch_result = acmacs::virus::name::parse_batch(batch, acmacs::virus::name::parse_fields::all, acmacs::virus::name::message_policy::full, nullptr, 3);
+    for (size_t no = 0; no < data.size(); ++no) {
+        if (batch_result[no] != data[no].expected) {
+            AD_ERROR("parse_batch: {} <-- \"{}\"  expected: \"{}\"", batch_result[no], data[no].raw_name, data[no].expected);
+            ++errors;
+        }
+    }
+
+    // parse_into() reusing the same output: nothing is left from the previous name
+    acmacs::virus::name::parsed_fields_t reused;
+    for (size_t no = data.size(); no > 0; --no) {
+        acmacs::virus::name::parse_into(data[no - 1].raw_name, reused, acmacs::virus::name::parse_fields::all, acmacs::virus::name::message_policy::full, acmacs::virus::name::warn_on_empty::no);
+        if (reused != data[no - 1].expected || reused.mutations != batch_result[no - 1].mutations || reused.country != batch_result[no - 1].country ||
+            reused.number_of_messages() != batch_result[no - 1].number_of_messages()) {
+            AD_ERROR("parse_into: {} <-- \"{}\"  expected: \"{}\"", reused, data[no - 1].raw_name, batch_result[no - 1]);
+            ++errors;
+        }
+    }
+
+    // the same virus spelled differently has the same identity hash, different viruses have different hashes
+    const auto hash_components = acmacs::virus::name::parse_fields::name | acmacs::virus::name::parse_fields::reassortant | acmacs::virus::name::parse_fields::passage | acmacs::virus::name::parse_fields::extra;
+    for (size_t no1 = 0; no1 < data.size(); ++no1) {
+        for (size_t no2 = no1 + 1; no2 < data.size(); ++no2) {
+            if (!batch_result[no1].good() || !batch_result[no2].good()) // raw names are hashed
+                continue;
+            if (const bool same = batch_result[no1] == data[no2].expected && batch_result[no2] == data[no1].expected;
+                same != (batch_result[no1].identity_hash(hash_components) == batch_result[no2].identity_hash(hash_components))) {
+                AD_ERROR("identity_hash: \"{}\" and \"{}\" are {}, hashes: {:016x} {:016x}", data[no1].raw_name, data[no2].raw_name, same ? "the same" : "different",
+                         batch_result[no1].identity_hash(hash_components), batch_result[no2].identity_hash(hash_components));
+                ++errors;
+            }
+        }
+    }
+    // names appended to buffers against joining fields
+    fmt::memory_buffer names_buffer;
+    acmacs::virus::name::append_names(batch_result, names_buffer, acmacs::virus::name::name_format::full_name);
+    const auto appended_names = acmacs::string::split(std::string_view{names_buffer.data(), names_buffer.size()}, "\n", acmacs::string::Split::KeepEmpty);
+    for (size_t no = 0; no < batch_result.size(); ++no) {
+        const auto& fields = batch_result[no];
+        const auto name = fields.good() ? acmacs::string::join(acmacs::string::join_slash, fields.subtype, fields.host, fields.location, fields.isolation, fields.year) : std::string{*fields.name()};
+        const auto full_name = fields.good() ? acmacs::string::join(acmacs::string::join_space, name, fields.reassortant, fields.extra, fields.passage) : fields.raw;
+        std::string name_target{"prefix "};
+        fields.name_to(name_target);
+        if (no >= appended_names.size() || appended_names[no] != full_name || name_target != fmt::format("prefix {}", name) || *fields.name() != name || fields.full_name() != full_name) {
+            AD_ERROR("name_to/full_name_to: \"{}\" \"{}\"  expected: \"{}\" \"{}\"", name_target, no < appended_names.size() ? appended_names[no] : std::string_view{}, name, full_name);
+            ++errors;
+        }
+    }
+
+    std::unordered_set<acmacs::virus::name_t> distinct_names;
+    std::unordered_set<acmacs::virus::type_subtype_t> distinct_subtypes;
+    for (const auto& fields : batch_result) {
+        distinct_names.insert(fields.name());
+        distinct_subtypes.insert(fields.subtype);
+    }
+    if (!distinct_names.contains(batch_result.front().name()) || !distinct_subtypes.contains(batch_result.front().subtype)) {
+        AD_ERROR("std::hash: name or subtype not found in unordered_set");
+        ++errors;
+    }
+
+    acmacs::virus::name::parsed_columns_t batch_columns;
+    acmacs::virus::name::parse_batch(batch, batch_columns, acmacs::virus::name::parse_fields::name | acmacs::virus::name::parse_fields::extra, acmacs::virus::name::message_policy::none, nullptr, 3);
+    for (size_t row = 0; row < data.size(); ++row) {
+        const auto& expected = batch_result[row];
+        const auto subtype = batch_columns.subtype[row] == acmacs::virus::name::subtype_code_other ? std::string{*expected.subtype} : acmacs::virus::name::subtype_from_code(batch_columns.subtype[row]);
+        if (subtype != *expected.subtype || batch_columns[batch_columns.host[row]] != *expected.host || batch_columns[batch_columns.location[row]] != expected.location ||
+            batch_columns[batch_columns.country[row]] != expected.country || batch_columns[batch_columns.continent[row]] != expected.continent ||
+            batch_columns[batch_columns.isolation[row]] != expected.isolation || batch_columns[batch_columns.extra[row]] != expected.extra || batch_columns[batch_columns.raw[row]] != expected.raw ||
+            (batch_columns.year[row] ? fmt::format("{}", batch_columns.year[row]) : std::string{}) != expected.year || batch_columns.good(row) != expected.good() ||
+            batch_columns.not_good(row) != expected.not_good()) {
+            AD_ERROR("parse_batch (columns): row {} differs from {} <-- \"{}\"", row, expected, data[row].raw_name);
+            ++errors;
+        }
+        // countries from locationdb are interned once, the same storage in all parse results
+        if (!expected.country.empty() && &*expected.country != &*acmacs::virus::interned_string_t{*expected.country}) {
+            AD_ERROR("interned_string_t: country \"{}\" is not interned <-- \"{}\"", expected.country, data[row].raw_name);
+            ++errors;
+        }
+    }
+
+    errors += test_bitmap_index(batch_columns);
+    errors += test_sort(batch_result);
+    errors += test_fuzzy_location_index();
+    errors += test_name_matcher();
+    errors += test_parse_into_allocations();
+
+    // name_t field accessors against splitting name by slashes
+    std::vector<acmacs::virus::name_t> names(batch_result.size());
+    std::transform(batch_result.begin(), batch_result.end(), names.begin(), [](const auto& fields) { return fields.name(); });
+    names.emplace_back("A/B");
+    names.emplace_back("B/VIC/HONG KONG/1/2020");
+    acmacs::virus::name_columns_t columns;
+    acmacs::virus::name_columns(names, columns, "-");
+    for (size_t row = 0; row < names.size(); ++row) {
+        const auto fields = acmacs::string::split(*names[row], "/", acmacs::string::Split::KeepEmpty);
+        const std::string_view expected_host = fields.size() == 5 ? fields[1] : "-", expected_location = fields.size() >= 3 ? fields[fields.size() - 3] : "-",
+                               expected_isolation = fields.size() >= 3 ? fields[fields.size() - 2] : "-";
+        if (columns.host[row] != expected_host || columns.location[row] != expected_location || columns.isolation[row] != expected_isolation ||
+            acmacs::virus::host(names[row], "-") != expected_host || acmacs::virus::location(names[row], "-") != expected_location || acmacs::virus::isolation(names[row], "-") != expected_isolation) {
+            AD_ERROR("name_fields_t: \"{}\" \"{}\" \"{}\" <-- \"{}\"  expected: \"{}\" \"{}\" \"{}\"", columns.host[row], columns.location[row], columns.isolation[row], names[row], expected_host,
+                     expected_location, expected_isolation);
+            ++errors;
+        }
+    }
+
+    errors += test_name_dictionary(names);
+
+    aggregators[0].merge(aggregators[1]);
+    if (aggregators[0].total() != all_messages.size()) {
+        AD_ERROR("message_aggregator_t: total {}, expected {}", aggregators[0].total(), all_messages.size());
+        ++errors;
+    }
+    for (const auto& msg : all_messages) {
+        if (const auto expected = static_cast<size_t>(std::count_if(all_messages.begin(), all_messages.end(), [&msg](const auto& en) { return en.key == msg.key; })); aggregators[0].count(msg.key) != expected) {
+            AD_ERROR("message_aggregator_t: \"{}\" count {}, expected {}", msg.key, aggregators[0].count(msg.key), expected);
+            ++errors;
+        }
+    }
+
+    errors += test_message_aggregator();
+
+    std::set<std::string> expected_not_found_locations;
+    acmacs::virus::name::collect_not_found_locations(expected_not_found_locations, all_messages);
+    if (const auto ranked = not_found_locations.ranked();
+        ranked.size() != expected_not_found_locations.size() ||
+        !std::all_of(ranked.begin(), ranked.end(), [&expected_not_found_locations](const auto& en) { return expected_not_found_locations.contains(en.location); })) {
+        AD_ERROR("not_found_locations_t: {} locations, expected {}", ranked.size(), expected_not_found_locations.size());
+        ++errors;
+    }
+
+    acmacs::virus::string_pool_t pool;
+    if (const auto restored = acmacs::virus::name::interned_messages_t{pool, all_messages}.to_messages();
+        restored.size() != all_messages.size() ||
+        !std::equal(restored.begin(), restored.end(), all_messages.begin(), [](const auto& msg1, const auto& msg2) { return msg1.key == msg2.key && msg1.value == msg2.value; })) {
+        AD_ERROR("interned_messages_t: restored messages differ");
+        ++errors;
+    }
+
     if (errors)
         throw std::runtime_error{fmt::format("test_builtin: {} errors found", errors)};
 
@@ -180,6 +399,641 @@ void test_builtin()
 
 // ----------------------------------------------------------------------
 
+// fields requested from parse() must be the same as in the full parse
+size_t test_projections(std::string_view raw_name, const acmacs::virus::name::parsed_fields_t& full)
+{
+    using namespace acmacs::virus::name;
+
+    const std::array projections{
+        parse_fields::location | parse_fields::year,
+        parse_fields::subtype,
+        parse_fields::location | parse_fields::isolation | parse_fields::year,
+        parse_fields::name,
+        parse_fields::reassortant,
+        parse_fields::passage | parse_fields::mutations,
+        parse_fields::extra,
+    };
+
+    size_t errors = 0;
+    for (const auto fields : projections) {
+        const auto projected = parse(raw_name, fields);
+        const auto field_mismatch = [fields](parse_fields field, const auto& lhs, const auto& rhs) { return wanted(fields, field) && lhs != rhs; };
+        if (field_mismatch(parse_fields::subtype, projected.subtype, full.subtype) || field_mismatch(parse_fields::host, projected.host, full.host) ||
+            field_mismatch(parse_fields::location, projected.location, full.location) || field_mismatch(parse_fields::location, projected.country, full.country) ||
+            field_mismatch(parse_fields::location, projected.continent, full.continent) || field_mismatch(parse_fields::isolation, projected.isolation, full.isolation) ||
+            field_mismatch(parse_fields::year, projected.year, full.year) || field_mismatch(parse_fields::reassortant, projected.reassortant, full.reassortant) ||
+            field_mismatch(parse_fields::passage, projected.passage, full.passage) || field_mismatch(parse_fields::mutations, projected.mutations, full.mutations) ||
+            field_mismatch(parse_fields::extra, projected.extra, full.extra) || projected.good() != full.good()) {
+            AD_ERROR("projection 0x{:x}: {} <-- \"{}\"  full parse: {}", static_cast<unsigned>(fields), projected, raw_name, full);
+            ++errors;
+        }
+    }
+    return errors;
+
+} // test_projections
+
+// ----------------------------------------------------------------------
+
+// message keys made with message_policy::count and message_policy::lazy and values of message_policy::lazy must be the same as with message_policy::full
+size_t test_message_policies(std::string_view raw_name, const acmacs::virus::name::parsed_fields_t& full)
+{
+    using namespace acmacs::virus::name;
+
+    message_counts_t expected{};
+    for (const auto& msg : full.messages) {
+        for (size_t key_no = 0; key_no < number_of_message_keys; ++key_no) {
+            if (to_string(static_cast<message_key>(key_no)) == msg.key)
+                ++expected[key_no];
+        }
+    }
+
+    size_t errors = 0;
+    if (const auto counted = parse(raw_name, message_policy::count); counted.message_counts() != expected || !counted.messages.empty() || !counted.lazy_messages().empty()) {
+        AD_ERROR("message_policy::count: {} <-- \"{}\"", counted.message_counts(), raw_name);
+        ++errors;
+    }
+    if (const auto lazy = parse(raw_name, message_policy::lazy); lazy.lazy_messages().size() != full.messages.size() || !lazy.messages.empty() ||
+                                                                   !std::equal(std::begin(lazy.lazy_messages()), std::end(lazy.lazy_messages()), std::begin(full.messages), [&lazy](const auto& lazy_msg, const auto& msg) {
+                                                                       const auto made = lazy_msg.message(lazy.raw);
+                                                                       return made.key == msg.key && made.value == msg.value;
+                                                                   })) {
+        AD_ERROR("message_policy::lazy: {} messages <-- \"{}\"", lazy.lazy_messages().size(), raw_name);
+        ++errors;
+    }
+    if (full.lazy_messages().data() != nullptr) { // storage for count and lazy policies is not allocated
+        AD_ERROR("message_policy::full: count/lazy message storage allocated <-- \"{}\"", raw_name);
+        ++errors;
+    }
+    if (const auto none = parse(raw_name, message_policy::none); none.number_of_messages() != 0) {
+        AD_ERROR("message_policy::none: {} messages <-- \"{}\"", none.number_of_messages(), raw_name);
+        ++errors;
+    }
+    return errors;
+
+} // test_message_policies
+
+// ----------------------------------------------------------------------
+
+// name_dictionary_t against sorted names, directly and after writing to a file and mapping it
+size_t test_name_dictionary(std::span<const acmacs::virus::name_t> names)
+{
+    std::vector<std::string> sorted(names.size());
+    std::transform(names.begin(), names.end(), sorted.begin(), [](const auto& name) { return *name; });
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    const auto check = [&sorted](const acmacs::virus::name_dictionary_t& dictionary, std::string_view label) {
+        size_t errors = 0;
+        if (dictionary.size() != sorted.size()) {
+            AD_ERROR("name_dictionary_t ({}): size {}, expected {}", label, dictionary.size(), sorted.size());
+            return size_t{1};
+        }
+        for (acmacs::virus::name_dictionary_t::id_t id = 0; id < sorted.size(); ++id) {
+            const auto prefix = std::string_view{sorted[id]}.substr(0, sorted[id].find('/', sorted[id].find('/') + 1) + 1); // subtype/location/ or subtype/host/
+            const auto [first, last] = dictionary.prefix_range(prefix);
+            const auto expected_first = static_cast<acmacs::virus::name_dictionary_t::id_t>(std::lower_bound(sorted.begin(), sorted.end(), prefix) - sorted.begin());
+            const auto expected_last = static_cast<acmacs::virus::name_dictionary_t::id_t>(std::find_if(sorted.begin() + expected_first, sorted.end(), [prefix](std::string_view name) { return !name.starts_with(prefix); }) - sorted.begin());
+            if (dictionary[id] != sorted[id] || dictionary.find(sorted[id]) != id || dictionary.lower_bound(sorted[id]) != id || first != expected_first || last != expected_last) {
+                AD_ERROR("name_dictionary_t ({}): id {} \"{}\": \"{}\" found: {} prefix \"{}\": [{}, {}) expected [{}, {})", label, id, sorted[id], dictionary[id], dictionary.find(sorted[id]).has_value(), prefix, first,
+                         last, expected_first, expected_last);
+                ++errors;
+            }
+        }
+        std::vector<std::string> scanned;
+        dictionary.for_each([&scanned](auto, std::string_view name) { scanned.emplace_back(name); });
+        if (scanned != sorted) {
+            AD_ERROR("name_dictionary_t ({}): for_each differs", label);
+            ++errors;
+        }
+        if (dictionary.find("A(H3N2)/NOT IN DICTIONARY/1/2020").has_value()) {
+            AD_ERROR("name_dictionary_t ({}): found name not in dictionary", label);
+            ++errors;
+        }
+        return errors;
+    };
+
+    size_t errors = 0;
+    for (const size_t bucket_size : {1, 3, 16}) {
+        acmacs::virus::name_dictionary_t dictionary{names, bucket_size};
+        errors += check(dictionary, fmt::format("bucket size {}", bucket_size));
+
+        const auto filename = (std::filesystem::temp_directory_path() / fmt::format("test-virus-name-dictionary-{}", ::getpid())).string();
+        dictionary.write(filename);
+        errors += check(acmacs::virus::name_dictionary_t::map(filename), fmt::format("mapped, bucket size {}", bucket_size));
+        std::filesystem::remove(filename);
+    }
+    return errors;
+
+} // test_name_dictionary
+
+// ----------------------------------------------------------------------
+
+// bitmap_index_t queries against scanning columns, row_bitmap_t set operations against std::set_* on random rows
+size_t test_bitmap_index(const acmacs::virus::name::parsed_columns_t& columns)
+{
+    using namespace acmacs::virus::name;
+
+    size_t errors = 0;
+    const auto expect = [&errors](const row_bitmap_t& bitmap, const std::vector<row_bitmap_t::row_t>& expected, std::string_view label) {
+        if (bitmap.rows() != expected || bitmap.count() != expected.size() || !std::all_of(expected.begin(), expected.end(), [&bitmap](auto row) { return bitmap.contains(row); })) {
+            AD_ERROR("bitmap_index_t: {}: {} rows, expected {}", label, bitmap.count(), expected.size());
+            ++errors;
+        }
+    };
+
+    bitmap_index_t index;
+    index.add(columns);
+    index.add(columns); // rows of the second batch follow the first one
+    const auto filename = (std::filesystem::temp_directory_path() / fmt::format("test-virus-name-bitmap-index-{}", ::getpid())).string();
+    index.write(filename);
+    const auto restored = bitmap_index_t::read(filename);
+    std::filesystem::remove(filename);
+
+    const auto select = [&columns](auto pred) {
+        std::vector<row_bitmap_t::row_t> rows;
+        for (size_t batch = 0; batch < 2; ++batch) {
+            for (size_t row = 0; row < columns.size(); ++row) {
+                if (pred(row))
+                    rows.push_back(static_cast<row_bitmap_t::row_t>(batch * columns.size() + row));
+            }
+        }
+        return rows;
+    };
+    for (const auto* idx : std::array<const bitmap_index_t*, 2>{&index, &restored}) {
+        for (size_t row = 0; row < columns.size(); ++row) {
+            const auto country = columns[columns.country[row]];
+            expect(idx->country(country), select([&](size_t rw) { return columns[columns.country[rw]] == country; }), fmt::format("country \"{}\"", country));
+            expect(idx->host(columns[columns.host[row]]) & idx->subtype(columns.subtype[row]),
+                   select([&](size_t rw) { return columns.host[rw] == columns.host[row] && columns.subtype[rw] == columns.subtype[row]; }), "host & subtype");
+            expect(idx->years(2010, 2017) - idx->continent(columns[columns.continent[row]]),
+                   select([&](size_t rw) { return columns.year[rw] >= 2010 && columns.year[rw] <= 2017 && columns.continent[rw] != columns.continent[row]; }), "years - continent");
+            expect(idx->location(columns[columns.location[row]]) | idx->year(columns.year[row]),
+                   select([&](size_t rw) { return columns.location[rw] == columns.location[row] || columns.year[rw] == columns.year[row]; }), "location | year");
+        }
+        expect(idx->all(), select([](size_t) { return true; }), "all");
+        expect(idx->continent("NOT A CONTINENT"), {}, "not in index");
+    }
+
+    // chunks in array and bitset form
+    std::mt19937 generator{42};
+    const auto random_rows = [&generator](uint32_t range, uint32_t density) {
+        std::vector<row_bitmap_t::row_t> rows;
+        for (uint32_t row = 0; row < range; ++row) {
+            if ((generator() % 100) < density)
+                rows.push_back(row);
+        }
+        return rows;
+    };
+    const auto to_bitmap = [](const std::vector<row_bitmap_t::row_t>& rows) {
+        row_bitmap_t bitmap;
+        for (const auto row : rows)
+            bitmap.add(row);
+        return bitmap;
+    };
+    for (const auto& [density1, density2] : {std::pair{1u, 2u}, std::pair{3u, 60u}, std::pair{70u, 50u}, std::pair{9u, 0u}}) {
+        const auto rows1 = random_rows(300000, density1), rows2 = random_rows(200000, density2);
+        const auto bitmap1 = to_bitmap(rows1), bitmap2 = to_bitmap(rows2);
+        std::vector<row_bitmap_t::row_t> expected;
+        std::set_intersection(rows1.begin(), rows1.end(), rows2.begin(), rows2.end(), std::back_inserter(expected));
+        expect(bitmap1 & bitmap2, expected, "row_bitmap_t &");
+        expected.clear();
+        std::set_union(rows1.begin(), rows1.end(), rows2.begin(), rows2.end(), std::back_inserter(expected));
+        expect(bitmap1 | bitmap2, expected, "row_bitmap_t |");
+        expected.clear();
+        std::set_difference(rows2.begin(), rows2.end(), rows1.begin(), rows1.end(), std::back_inserter(expected));
+        expect(bitmap2 - bitmap1, expected, "row_bitmap_t -");
+    }
+    return errors;
+
+} // test_bitmap_index
+
+// ----------------------------------------------------------------------
+
+// sort() against natural order of names made from known fields
+size_t test_sort(std::vector<acmacs::virus::name::parsed_fields_t> fields)
+{
+    using namespace acmacs::virus::name;
+
+    const auto make = [](std::string_view subtype, std::string_view location, std::string_view isolation, std::string_view year) {
+        parsed_fields_t fields;
+        fields.subtype = acmacs::virus::type_subtype_t{subtype};
+        fields.location = acmacs::virus::interned_string_t{location};
+        fields.isolation = isolation;
+        fields.year = year;
+        return fields;
+    };
+    const std::vector expected{
+        make("A(H1N1)", "TEXAS", "5", "2019"),      make("A(H3N2)", "HONG KONG", "9", "2013"),    make("A(H3N2)", "HONG KONG", "9", "2014"),
+        make("A(H3N2)", "HONG KONG", "10", "2014"), make("A(H3N2)", "HONG KONG", "10A", "2014"),  make("A(H3N2)", "HONG KONG", "4801", "2014"),
+        make("A(H3N2)", "HONG KONG", "VB1", "2014"), make("A(H3N2)", "PERTH", "16", "2009"),      make("B", "BRISBANE", "60", "2008"),
+    };
+    std::vector<parsed_fields_t> to_sort(expected.rbegin(), expected.rend());
+    sort(to_sort, 2);
+
+    size_t errors = 0;
+    if (!std::equal(to_sort.begin(), to_sort.end(), expected.begin(), [](const auto& sorted, const auto& exp) { return sorted.name() == exp.name(); })) {
+        AD_ERROR("sort: natural order of names differs");
+        ++errors;
+    }
+
+    // parallel sort of parse results is the same as sorting by the same comparison in a single thread
+    fields.insert(fields.end(), fields.begin(), fields.end());
+    const auto keys = sort_keys(fields, 1);
+    std::vector<size_t> expected_order(fields.size());
+    std::iota(expected_order.begin(), expected_order.end(), size_t{0});
+    std::sort(expected_order.begin(), expected_order.end(), [&keys, &fields](size_t index1, size_t index2) {
+        return std::tie(keys[index1], fields[index1].isolation, *fields[index1].host, index1) < std::tie(keys[index2], fields[index2].isolation, *fields[index2].host, index2);
+    });
+    for (const size_t threads : {1, 3, 8}) {
+        if (sorted_order(fields, threads) != expected_order) {
+            AD_ERROR("sorted_order ({} threads) differs", threads);
+            ++errors;
+        }
+    }
+    return errors;
+
+} // test_sort
+
+// ----------------------------------------------------------------------
+
+// fuzzy_location_index_t against scanning all known locations
+size_t test_fuzzy_location_index()
+{
+    using namespace acmacs::virus::name;
+
+    const std::array known{"DELI SERDANG", "HONG KONG", "SINGAPORE", "TEXAS", "TEHRAN", "TEXAS CITY", "KHABAROVSK", "NOVOSIBIRSK", "ST. PETERSBURG", "VINA DEL MAR", "GUANGDONG", "GUANGXI", "PERTH", "PERU"};
+    fuzzy_location_index_t index{2};
+    for (const auto* location : known)
+        index.add(location);
+
+    size_t errors = 0;
+    const auto check = [&index, &known, &errors](std::string_view look_for) {
+        std::vector<std::pair<size_t, std::string_view>> expected;
+        for (const std::string_view location : known) {
+            if (const auto dist = fuzzy_location_index_t::distance(look_for, location, index.max_distance()); dist <= index.max_distance())
+                expected.emplace_back(dist, location);
+        }
+        std::sort(expected.begin(), expected.end());
+        const auto found = index.find(look_for, known.size());
+        if (found.size() != expected.size() ||
+            !std::equal(found.begin(), found.end(), expected.begin(), [](const auto& fnd, const auto& exp) { return fnd.distance == exp.first && fnd.location == exp.second; })) {
+            AD_ERROR("fuzzy_location_index_t: \"{}\": {} candidates, expected {}", look_for, found.size(), expected.size());
+            ++errors;
+        }
+    };
+
+    std::mt19937 generator{7};
+    for (const std::string_view location : known) {
+        for (size_t variant = 0; variant < 20; ++variant) {
+            std::string typo{location};
+            for (size_t edit = generator() % 4; edit > 0 && !typo.empty(); --edit) {
+                const auto pos = generator() % typo.size();
+                switch (generator() % 4) {
+                    case 0:
+                        typo.erase(pos, 1);
+                        break;
+                    case 1:
+                        typo.insert(pos, 1, static_cast<char>('A' + generator() % 26));
+                        break;
+                    case 2:
+                        typo[pos] = static_cast<char>('A' + generator() % 26);
+                        break;
+                    case 3:
+                        if ((pos + 1) < typo.size())
+                            std::swap(typo[pos], typo[pos + 1]);
+                        break;
+                }
+            }
+            check(typo);
+        }
+    }
+
+    if (const auto found = index.find("Deliserdang"); found.empty() || found.front().location != "DELI SERDANG" || found.front().distance != 1) {
+        AD_ERROR("fuzzy_location_index_t: \"Deliserdang\" is not resolved to \"DELI SERDANG\"");
+        ++errors;
+    }
+    fuzzy_location_index_t mixed_case;
+    mixed_case.add("Texas");
+    if (const auto found = mixed_case.find("Texas"); found.size() != 1 || found.front().location != "TEXAS" || found.front().distance != 0) {
+        AD_ERROR("fuzzy_location_index_t: \"Texas\" added in mixed case is not found");
+        ++errors;
+    }
+    if (fuzzy_location_index_t::distance("TEXAS", "TEXSA", 2) != 1 || fuzzy_location_index_t::distance("TEXAS", "PERTH", 2) != 3) {
+        AD_ERROR("fuzzy_location_index_t::distance");
+        ++errors;
+    }
+
+    not_found_locations_t not_found;
+    not_found.add("SINGAPOR", "A/SINGAPOR/1/2020");
+    not_found.add("SINGAPOR", "A/SINGAPOR/2/2020");
+    not_found.add("XXXXXXXX", "A/XXXXXXXX/1/2020");
+    if (const auto resolved = index.find(not_found, 3, 2); resolved.size() != 2 || resolved[0].location != "SINGAPOR" || resolved[0].count != 2 || resolved[0].candidates.empty() ||
+                                                           resolved[0].candidates.front().location != "SINGAPORE" || !resolved[1].candidates.empty()) {
+        AD_ERROR("fuzzy_location_index_t: bulk resolution of not found locations");
+        ++errors;
+    }
+    return errors;
+
+} // test_fuzzy_location_index
+
+// ----------------------------------------------------------------------
+
+// ranking and eviction of location-not-found values by message_aggregator_t against exact counts
+size_t test_message_aggregator()
+{
+    using namespace acmacs::virus::name;
+
+    size_t errors = 0;
+    std::array<std::map<std::string, size_t>, 2> real_counts;
+    std::array<message_aggregator_t, 2> aggregators{message_aggregator_t{1, 3, 4}, message_aggregator_t{1, 3, 4}};
+    const auto add = [&](size_t aggregator_no, std::string_view value, size_t count) {
+        for (size_t no = 0; no < count; ++no)
+            aggregators[aggregator_no].add(acmacs::messages::message_t{acmacs::messages::key::location_not_found, value});
+        real_counts[aggregator_no][std::string{value}] += count;
+    };
+    add(0, "AAA", 10);
+    add(0, "BBB", 8);
+    add(0, "CCC", 6);
+    add(0, "DDD", 4);
+    add(0, "EEE", 1); // DDD is evicted, EEE inherits its count
+    add(1, "AAA", 5);
+    add(1, "FFF", 3);
+    add(1, "GGG", 2);
+    add(1, "HHH", 2);
+    add(1, "III", 1); // GGG is evicted
+
+    // expected_top: the first values of top_values()
+    const auto check = [&errors](const message_aggregator_t& aggregator, std::map<std::string, size_t>& real, std::initializer_list<std::pair<std::string_view, size_t>> expected_top, size_t min_overestimation) {
+        const auto top = aggregator.top_values();
+        if (top.size() < expected_top.size() ||
+            !std::equal(expected_top.begin(), expected_top.end(), top.begin(), [](const auto& expected, const auto& found) { return found.first == expected.first && found.second == expected.second; })) {
+            AD_ERROR("message_aggregator_t::top_values: {} values, the first one: \"{}\" {}", top.size(), top.empty() ? std::string{} : top.front().first, top.empty() ? size_t{0} : top.front().second);
+            ++errors;
+        }
+        if (aggregator.max_overestimation() < min_overestimation) {
+            AD_ERROR("message_aggregator_t::max_overestimation: {}, expected at least {}", aggregator.max_overestimation(), min_overestimation);
+            ++errors;
+        }
+        for (const auto& [value, count] : top) {
+            if (count < real[value] || count > real[value] + aggregator.max_overestimation()) {
+                AD_ERROR("message_aggregator_t: \"{}\" count {} is out of bounds, real count {}", value, count, real[value]);
+                ++errors;
+            }
+        }
+    };
+    check(aggregators[0], real_counts[0], {{"AAA", 10}, {"BBB", 8}, {"CCC", 6}}, 4);
+    check(aggregators[1], real_counts[1], {{"AAA", 5}, {"FFF", 3}, {"III", 3}}, 2);
+    aggregators[0].merge(aggregators[1]); // values of aggregators[1] evict some of aggregators[0]
+    for (const auto& [value, count] : real_counts[1])
+        real_counts[0][value] += count;
+    check(aggregators[0], real_counts[0], {{"AAA", 15}}, 4 + 2);   // errors of both summaries add up
+    return errors;
+
+} // test_message_aggregator
+
+// ----------------------------------------------------------------------
+
+static std::vector<acmacs::virus::name::parsed_fields_t> matcher_names(size_t size, std::mt19937& generator)
+{
+    const std::array subtypes{"A(H1N1)", "A(H3N2)", "B"};
+    const std::array locations{"HONG KONG", "SINGAPORE", "TEXAS", "PERTH", "VICTORIA", "GUANGDONG", "NEW YORK", "BRISBANE", "KHABAROVSK", "DELI SERDANG"};
+    std::vector<acmacs::virus::name::parsed_fields_t> names(size);
+    for (auto& fields : names) {
+        fields.subtype = acmacs::virus::type_subtype_t{subtypes[generator() % subtypes.size()]};
+        fields.location = acmacs::virus::interned_string_t{locations[generator() % locations.size()]};
+        fields.year = fmt::format("{}", 2000 + generator() % 22);
+        fields.isolation = fmt::format("{}", generator() % 100000);
+        if (generator() % 4 == 0)
+            fields.isolation.append(fmt::format("-{:02d}", generator() % 100));
+    }
+    return names;
+}
+
+// query variant of a name: isolation with leading zeros, a different separator or a typo
+static acmacs::virus::name::parsed_fields_t matcher_query(const acmacs::virus::name::parsed_fields_t& source, std::mt19937& generator)
+{
+    auto query{source};
+    switch (generator() % 4) {
+        case 0:
+            query.isolation.insert(0, "00");
+            break;
+        case 1:
+            if (const auto dash = query.isolation.find('-'); dash != std::string::npos)
+                query.isolation[dash] = '/';
+            break;
+        case 2:
+            query.isolation[generator() % query.isolation.size()] = static_cast<char>('0' + generator() % 10);
+            break;
+        case 3:
+            break;
+    }
+    return query;
+}
+
+// name_matcher_t against scanning all reference names
+size_t test_name_matcher()
+{
+    using namespace acmacs::virus::name;
+
+    size_t errors = 0;
+
+    // bit-parallel edit distance against dynamic programming
+    const auto levenshtein = [](std::string_view s1, std::string_view s2) {
+        std::vector<std::vector<size_t>> dist(s1.size() + 1, std::vector<size_t>(s2.size() + 1));
+        for (size_t pos1 = 0; pos1 <= s1.size(); ++pos1) {
+            for (size_t pos2 = 0; pos2 <= s2.size(); ++pos2) {
+                if (pos1 == 0 || pos2 == 0)
+                    dist[pos1][pos2] = pos1 + pos2;
+                else
+                    dist[pos1][pos2] = std::min({dist[pos1 - 1][pos2] + 1, dist[pos1][pos2 - 1] + 1, dist[pos1 - 1][pos2 - 1] + (s1[pos1 - 1] == s2[pos2 - 1] ? 0 : 1)});
+            }
+        }
+        return dist[s1.size()][s2.size()];
+    };
+    std::mt19937 generator{11};
+    const auto random_string = [&generator](size_t max_length) {
+        std::string result(generator() % (max_length + 1), ' ');
+        for (auto& sym : result)
+            sym = static_cast<char>('A' + generator() % 4);
+        return result;
+    };
+    for (size_t attempt = 0; attempt < 2000; ++attempt) {
+        const auto s1 = random_string(attempt < 1900 ? 20 : 90), s2 = random_string(attempt < 1900 ? 20 : 90);
+        if (const auto dist = name_matcher_t::edit_distance(s1, s2), expected = levenshtein(s1, s2); dist != expected) {
+            AD_ERROR("name_matcher_t::edit_distance(\"{}\", \"{}\"): {}, expected {}", s1, s2, dist, expected);
+            ++errors;
+        }
+    }
+
+    if (name_matcher_t::normalize_isolation("0019") != "19" || name_matcher_t::normalize_isolation("SWL 01/ 2") != "SWL-1-2" || name_matcher_t::normalize_isolation("10-02") != "10-2" ||
+        name_matcher_t::normalize_isolation("0") != "0") {
+        AD_ERROR("name_matcher_t::normalize_isolation");
+        ++errors;
+    }
+
+    const auto reference = matcher_names(2000, generator);
+    std::vector<parsed_fields_t> queries;
+    for (size_t no = 0; no < 500; ++no)
+        queries.push_back(matcher_query(reference[generator() % reference.size()], generator));
+    queries.push_back(matcher_query(reference.front(), generator));
+    queries.back().year = "1999"; // block is not in the reference
+    queries.push_back(parsed_fields_t{});
+
+    const name_matcher_t matcher{reference};
+    const auto found = matcher.match(queries, 0.7, 2);
+    for (size_t no = 0; no < queries.size(); ++no) {
+        std::optional<name_matcher_t::match_t> expected;
+        if (queries[no].good()) {
+            const auto isolation = name_matcher_t::normalize_isolation(queries[no].isolation);
+            for (size_t ref = 0; ref < reference.size(); ++ref) {
+                if (reference[ref].subtype == queries[no].subtype && reference[ref].location == queries[no].location && reference[ref].year == queries[no].year) {
+                    if (const auto score = name_matcher_t::isolation_similarity(isolation, name_matcher_t::normalize_isolation(reference[ref].isolation));
+                        score >= 0.7 && (!expected.has_value() || score > expected->score))
+                        expected = name_matcher_t::match_t{.reference = ref, .score = score};
+                }
+            }
+        }
+        if (found[no].has_value() != expected.has_value() || (expected.has_value() && (found[no]->score != expected->score || found[no]->reference != expected->reference))) {
+            AD_ERROR("name_matcher_t: query {} \"{}\": found: {}, expected: {}", no, queries[no].isolation, found[no].has_value(), expected.has_value());
+            ++errors;
+        }
+    }
+
+    auto query{reference.front()};
+    query.isolation.insert(0, "0");
+    if (const auto match = matcher.match(query); !match.has_value() || match->score != 1.0) {
+        AD_ERROR("name_matcher_t: leading zero in isolation \"{}\" is not ignored", query.isolation);
+        ++errors;
+    }
+    return errors;
+
+} // test_name_matcher
+
+// ----------------------------------------------------------------------
+
+// test-virus-name --match-benchmark [size] : size references against size queries
+void test_match_benchmark(size_t size)
+{
+    std::mt19937 generator{13};
+    const auto reference = matcher_names(size, generator);
+    std::vector<acmacs::virus::name::parsed_fields_t> queries(size);
+    std::transform(reference.begin(), reference.end(), queries.begin(), [&generator](const auto& fields) { return matcher_query(fields, generator); });
+    std::shuffle(queries.begin(), queries.end(), generator);
+
+    const auto start = std::chrono::steady_clock::now();
+    const acmacs::virus::name::name_matcher_t matcher{reference};
+    const auto indexed = std::chrono::steady_clock::now();
+    const auto found = matcher.match(queries);
+    const auto matched = std::chrono::steady_clock::now();
+    const auto elapsed = [](auto first, auto last) { return std::chrono::duration_cast<std::chrono::milliseconds>(last - first).count(); };
+    AD_INFO("name_matcher_t: {} references indexed in {}ms, {} queries ({} matched) in {}ms", size, elapsed(start, indexed), size, std::count_if(found.begin(), found.end(), [](const auto& match) { return match.has_value(); }), elapsed(indexed, matched));
+
+} // test_match_benchmark
+
+// ----------------------------------------------------------------------
+
+// parse_into() into the same output after warm-up: scratch buffers of
+// parse_into() and buffers of output are reused, no allocations.
+// Names are without extra (passage and reassortant are matched by std::regex
+// which allocates) and fields fit into small string buffers.
+size_t test_parse_into_allocations()
+{
+    const std::array names{
+        "A/SINGAPORE/INFIMH-16-0019/2016", "A/Lyon/CHU18.54.48/2018", "A/Zambia/13/174/2013", "A/chicken/Ghana/7/2015", "A/wigeon/Italy/6127-23/2007", "A/Medellin/FLU8292/2007",
+    };
+
+    size_t errors = 0;
+    acmacs::virus::name::parsed_fields_t output;
+    for (size_t warm_up = 0; warm_up < 2; ++warm_up) {
+        for (const auto* name : names)
+            acmacs::virus::name::parse_into(name, output, acmacs::virus::name::parse_fields::all, acmacs::virus::name::message_policy::none, acmacs::virus::name::warn_on_empty::no);
+    }
+    for (const auto* name : names) {
+        const auto before = allocations;
+        acmacs::virus::name::parse_into(name, output, acmacs::virus::name::parse_fields::all, acmacs::virus::name::message_policy::none, acmacs::virus::name::warn_on_empty::no);
+        if (const auto made = allocations - before; made != 0) {
+            AD_ERROR("parse_into: {} allocations after warm-up <-- \"{}\"", made, name);
+            ++errors;
+        }
+    }
+    return errors;
+
+} // test_parse_into_allocations
+
+// ----------------------------------------------------------------------
+
+bool diverges(const acmacs::virus::name::parsed_fields_t& single_pass, const acmacs::virus::name::parsed_fields_t& reference)
+{
+    return single_pass.good() != reference.good() || single_pass.full_name() != reference.full_name() || single_pass.country != reference.country;
+
+} // diverges
+
+// ----------------------------------------------------------------------
+
+// Builtin names parse_single_pass() is known to parse differently from
+// parse() because of what it does not handle (see its comment in
+// virus-name-normalize.hh), divergence on any other builtin name is an error.
+std::string_view known_single_pass_divergence(std::string_view raw_name)
+{
+    using namespace std::string_view_literals;
+    constexpr const std::string_view reassortant_in_front{"reassortant in front of the name is not handled"};
+    constexpr const std::string_view no_isolation{"host and location without isolation, split by position"};
+    constexpr const std::string_view isolation_parts{"isolation of several parts, only the last one is used"};
+    constexpr const std::string_view unknown_location{"location not in locationdb is rejected"};
+    constexpr const std::string_view nibsc_extra{"(year/number) after NIBSC/NYMC reassortant is kept in extra"};
+    constexpr const std::string_view slash_in_extra{"parts of extra after the year are joined differently"};
+
+    static constexpr const std::array known{
+        std::pair{"IVR-153 (A/CALIFORNIA/07/2009)"sv, reassortant_in_front},
+        std::pair{"A/reassortant/IDCDC-RG22(New York/18/2009 x Puerto Rico/8/1934)"sv, reassortant_in_front},
+        std::pair{"A/reassortant/IgYRP13.c1(California/07/2004 x Puerto Rico/8/1934)"sv, reassortant_in_front},
+        std::pair{"A/REASSORTANT/X-83(CHILE/1/1983 X X-31)(H1N1)"sv, reassortant_in_front},
+        std::pair{"A/X-53A(Puerto Rico/8/1934-New Jersey/11/1976)"sv, reassortant_in_front},
+        std::pair{"A/swine/Chachoengsao/2003"sv, no_isolation},
+        std::pair{"A/chicken/Yunnan/Kunming/2007"sv, no_isolation},
+        std::pair{"A/Zambia/13/174/2013"sv, isolation_parts},
+        std::pair{"A/Algeria/G0281/16/2016"sv, isolation_parts},
+        std::pair{"A/QUAIL/some unknown location/0025/2016(H5N1)"sv, unknown_location},
+        std::pair{"A/some location/57(H2N2)"sv, unknown_location},
+        std::pair{"A/Brisbane/01/2018  NYMC-X-311 (18/160)"sv, nibsc_extra},
+        std::pair{"A/California/07/2009 NIBRG-121xp (09/268)"sv, nibsc_extra},
+        std::pair{"A/BONN/2/2020_PR8-HY-HA-R142G-HA-K92R/Y159F/K189N"sv, slash_in_extra},
+    };
+
+    if (const auto found = std::find_if(known.begin(), known.end(), [raw_name](const auto& entry) { return entry.first == raw_name; }); found != known.end())
+        return found->second;
+    return {};
+
+} // known_single_pass_divergence
+
+// ----------------------------------------------------------------------
+
+// test-virus-name --diff <file> ... : parse_single_pass() against parse() over names in files (one per line)
+void test_differential(int argc, const char* const* argv)
+{
+    size_t names{0}, divergent{0}, good_in_parse_only{0}, good_in_single_pass_only{0};
+    for (int arg = 0; arg < argc; ++arg) {
+        const std::string data = acmacs::file::read(argv[arg]);
+        for (const auto& line : acmacs::string::split(data, "\n", acmacs::string::Split::RemoveEmpty)) {
+            ++names;
+            const auto reference = acmacs::virus::name::parse(line, acmacs::virus::name::message_policy::none, acmacs::virus::name::warn_on_empty::no);
+            const auto single_pass = acmacs::virus::name::parse_single_pass(line, acmacs::virus::name::parse_fields::all, acmacs::virus::name::message_policy::none);
+            if (diverges(single_pass, reference)) {
+                ++divergent;
+                if (reference.good() && !single_pass.good())
+                    ++good_in_parse_only;
+                else if (!reference.good() && single_pass.good())
+                    ++good_in_single_pass_only;
+                fmt::print("\"{}\"\n    parse:       {}\n    single pass: {}\n", line, reference.full_name(), single_pass.full_name());
+            }
+        }
+    }
+    fmt::print("\nNames: {}  divergent: {}  good in parse only: {}  good in single pass only: {}\n", names, divergent, good_in_parse_only, good_in_single_pass_only);
+
+} // test_differential
+
+// ----------------------------------------------------------------------
+
 void test_from_command_line(int argc, const char* const* argv)
 {
     for (int arg = 1; arg < argc; ++arg) {
@@ -90,6 +90,10 @@ template <> struct fmt::formatter<acmacs::virus::type_subtype_t> : public fmt::f
     template <typename FormatContext> auto format(const acmacs::virus::type_subtype_t& ts, FormatContext& ctx) { return fmt::format_to(ctx.out(), "{}", static_cast<std::string_view>(ts)); }
 };
 
+template <> struct std::hash<acmacs::virus::type_subtype_t>
+{
+    size_t operator()(const acmacs::virus::type_subtype_t& ts) const noexcept { return std::hash<std::string_view>{}(*ts); }
+};
 
 // ----------------------------------------------------------------------
 /// Local Variables:
@@ -0,0 +1,76 @@
+#include "acmacs-base/fmt.hh"
+#include "acmacs-virus/virus-name-columns.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    enum subtype_code_type : subtype_code_t { type_a = 1, type_b = 2 };
+    constexpr const subtype_code_t subtype_code_max_number{0x3F};
+
+    // reads number in [1, subtype_code_max_number] at pos, returns 0 if there is no number
+    inline subtype_code_t subtype_code_number(std::string_view source, size_t& pos)
+    {
+        subtype_code_t number{0};
+        for (; pos < source.size() && source[pos] >= '0' && source[pos] <= '9'; ++pos) {
+            number = static_cast<subtype_code_t>(number * 10 + (source[pos] - '0'));
+            if (number > subtype_code_max_number)
+                return 0;
+        }
+        return number;
+    }
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::subtype_code_t acmacs::virus::name::subtype_code(std::string_view type_subtype) noexcept
+{
+    if (type_subtype.empty())
+        return 0;
+    subtype_code_t code{subtype_code_other};
+    if (type_subtype == "B")
+        code = type_b << 12;
+    else if (type_subtype == "A")
+        code = type_a << 12;
+    else if (type_subtype.size() > 4 && type_subtype.substr(0, 3) == "A(H" && type_subtype.back() == ')') {
+        size_t pos{3};
+        if (const auto h_number = subtype_code_number(type_subtype, pos); h_number != 0) {
+            subtype_code_t n_number{0};
+            if (pos < type_subtype.size() && type_subtype[pos] == 'N')
+                n_number = subtype_code_number(type_subtype, ++pos);
+            if (pos == (type_subtype.size() - 1))
+                code = static_cast<subtype_code_t>((type_a << 12) | (h_number << 6) | n_number);
+        }
+    }
+    // leading zeros and N0 are not restored
+    if (code != subtype_code_other && subtype_from_code(code) != type_subtype)
+        return subtype_code_other;
+    return code;
+
+} // acmacs::virus::name::subtype_code
+
+// ----------------------------------------------------------------------
+
+std::string acmacs::virus::name::subtype_from_code(subtype_code_t code)
+{
+    const auto h_number = (code >> 6) & subtype_code_max_number, n_number = code & subtype_code_max_number;
+    switch (code == subtype_code_other ? 0 : code >> 12) {
+        case type_a:
+            if (h_number == 0)
+                return "A";
+            else if (n_number == 0)
+                return fmt::format("A(H{})", h_number);
+            else
+                return fmt::format("A(H{}N{})", h_number, n_number);
+        case type_b:
+            return "B";
+    }
+    return {};
+
+} // acmacs::virus::name::subtype_from_code
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
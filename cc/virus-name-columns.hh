@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+#include "acmacs-virus/string-pool.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    // Numeric code of type_subtype_t: 0 - empty, type in bits 12-13 (1 - A,
+    // 2 - B), H number in bits 6-11, N number in bits 0-5. Subtypes that
+    // cannot be restored from such code are subtype_code_other.
+    using subtype_code_t = uint16_t;
+    constexpr const subtype_code_t subtype_code_other{std::numeric_limits<subtype_code_t>::max()};
+
+    subtype_code_t subtype_code(std::string_view type_subtype) noexcept;
+    std::string subtype_from_code(subtype_code_t code); // empty for 0 and subtype_code_other
+
+    // ----------------------------------------------------------------------
+
+    // Parse results of a batch of names in columns (parse_batch(names,
+    // parsed_columns_t&, ...)), row N is for the Nth name. Strings that
+    // repeat across names (host, location, country, continent) are stored
+    // once in the pool and referred to by id, strings specific to a name
+    // (isolation, extra, raw) are slices of the shared buffer.
+    struct parsed_columns_t
+    {
+        using id_t = string_pool_t::id_t;
+        static constexpr const id_t no_id{std::numeric_limits<id_t>::max()}; // empty field
+
+        struct text_t
+        {
+            uint64_t offset{0}; // in buffer, text of a batch may exceed 4GB
+            uint32_t length{0}; // text of one name
+        };
+
+        string_pool_t pool{};
+        std::string buffer{};
+
+        std::vector<subtype_code_t> subtype{};
+        std::vector<id_t> host{};
+        std::vector<id_t> location{};
+        std::vector<id_t> country{};
+        std::vector<id_t> continent{};
+        std::vector<uint16_t> year{}; // 0 if there is no year
+        std::vector<text_t> isolation{};
+        std::vector<text_t> extra{};
+        std::vector<text_t> raw{};
+        std::vector<uint64_t> good_bits{};     // bit N of word N / 64 is set if parsed_fields_t::good() for row N
+        std::vector<uint64_t> not_good_bits{}; // parsed_fields_t::not_good()
+
+        size_t size() const noexcept { return raw.size(); }
+        bool good(size_t row) const noexcept { return (good_bits[row / 64] >> (row % 64)) & 1; }
+        bool not_good(size_t row) const noexcept { return (not_good_bits[row / 64] >> (row % 64)) & 1; }
+        std::string_view operator[](id_t id) const { return id == no_id ? std::string_view{} : pool[id]; }
+        std::string_view operator[](const text_t& text) const noexcept { return std::string_view{buffer}.substr(text.offset, text.length); }
+    };
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
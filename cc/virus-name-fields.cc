@@ -2,7 +2,6 @@
 #include <cctype>
 
 #include "acmacs-base/string-join.hh"
-#include "acmacs-base/string-split.hh"
 #include "acmacs-virus/virus-name.hh"
 #include "acmacs-virus/passage.hh"
 
@@ -35,12 +34,45 @@ std::optional<size_t> acmacs::virus::v2::year(const name_t& name) noexcept
 
 // ----------------------------------------------------------------------
 
+acmacs::virus::v2::name_fields_t::name_fields_t(std::string_view name) noexcept : name_{name}
+{
+    for (size_t pos = name_.find('/'); pos != std::string_view::npos; pos = name_.find('/', pos + 1)) {
+        if (slashes_ < first_.size())
+            first_[slashes_] = pos;
+        last_[0] = last_[1];
+        last_[1] = last_[2];
+        last_[2] = pos;
+        ++slashes_;
+    }
+
+} // acmacs::virus::v2::name_fields_t::name_fields_t
+
+// ----------------------------------------------------------------------
+
+std::string_view acmacs::virus::v2::name_fields_t::without_subtype() const noexcept
+{
+    using namespace std::string_view_literals;
+    if (const auto subtype = field(0, first_[0]); slashes_ >= 2 && subtype.size() >= 1) {
+        switch (subtype[0]) {
+            case 'A':
+                if (subtype.size() == 1 || subtype[1] == '(')
+                    return name_.substr(subtype.size() + 1);
+                break;
+            case 'B':
+                if (subtype.size() == 1 || (subtype.size() == 2 && (subtype[1] == 'V' || subtype[1] == 'Y')) || subtype.substr(1, 3) == "VIC"sv || subtype.substr(1, 3) == "YAM"sv)
+                    return name_.substr(subtype.size() + 1);
+                break;
+        }
+    }
+    return name_;
+
+} // acmacs::virus::v2::name_fields_t::without_subtype
+
+// ----------------------------------------------------------------------
+
 std::string_view acmacs::virus::v2::host(const name_t& name, std::string_view if_not_found) noexcept
 {
-    if (const auto fields = acmacs::string::split(*name, "/"); fields.size() == 5)
-        return fields[1];
-    else
-        return if_not_found;
+    return name_fields_t{name}.host(if_not_found);
 
 } // acmacs::virus::v2::host
 
@@ -48,10 +80,7 @@ std::string_view acmacs::virus::v2::host(const name_t& name, std::string_view if
 
 std::string_view acmacs::virus::v2::location(const name_t& name, std::string_view if_not_found) noexcept
 {
-    if (const auto fields = acmacs::string::split(*name, "/"); fields.size() >= 3)
-        return fields[fields.size() - 3];
-    else
-        return if_not_found;
+    return name_fields_t{name}.location(if_not_found);
 
 } // acmacs::virus::v2::location
 
@@ -59,10 +88,7 @@ std::string_view acmacs::virus::v2::location(const name_t& name, std::string_vie
 
 std::string_view acmacs::virus::v2::isolation(const name_t& name, std::string_view if_not_found) noexcept
 {
-    if (const auto fields = acmacs::string::split(*name, "/"); fields.size() >= 3)
-        return fields[fields.size() - 2];
-    else
-        return if_not_found;
+    return name_fields_t{name}.isolation(if_not_found);
 
 } // acmacs::virus::v2::isolation
 
@@ -70,23 +96,27 @@ std::string_view acmacs::virus::v2::isolation(const name_t& name, std::string_vi
 
 std::string_view acmacs::virus::v2::without_subtype(const name_t& name) noexcept
 {
-    using namespace std::string_view_literals;
-    if (const auto fields = acmacs::string::split(*name, "/"); fields.size() >= 3 && fields[0].size() >= 1) {
-        switch (fields[0][0]) {
-            case 'A':
-                if (fields[0].size() == 1 || fields[0][1] == '(')
-                    return std::string_view{*name}.substr(fields[0].size() + 1);
-                break;
-            case 'B':
-                if (fields[0].size() == 1 || (fields[0].size() == 2 && (fields[0][1] == 'V' || fields[0][1] == 'Y')) || fields[0].substr(1, 3) == "VIC"sv || fields[0].substr(1, 3) == "YAM"sv)
-                    return std::string_view{*name}.substr(fields[0].size() + 1);
-                break;
-        }
-    }
-    return *name;
+    return name_fields_t{name}.without_subtype();
 
 } // acmacs::virus::v2::without_subtype
 
+// ----------------------------------------------------------------------
+
+void acmacs::virus::v2::name_columns(std::span<const name_t> names, name_columns_t& columns, std::string_view if_not_found)
+{
+    columns.host.resize(names.size());
+    columns.location.resize(names.size());
+    columns.isolation.resize(names.size());
+    columns.year.resize(names.size());
+    for (size_t row = 0; row < names.size(); ++row) {
+        const name_fields_t fields{names[row]};
+        columns.host[row] = fields.host(if_not_found);
+        columns.location[row] = fields.location(if_not_found);
+        columns.isolation[row] = fields.isolation(if_not_found);
+        columns.year[row] = year(names[row]);
+    }
+
+} // acmacs::virus::v2::name_columns
 
 // ----------------------------------------------------------------------
 /// Local Variables:
@@ -1,4 +1,10 @@
 #include <array>
+#include <numeric>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+#include <cstring>
+#include <cerrno>
 
 #include "acmacs-base/string-split.hh"
 #include "acmacs-base/string-join.hh"
@@ -11,20 +17,68 @@
 #include "acmacs-base/regex.hh"
 #include "locationdb/locdb.hh"
 #include "acmacs-virus/virus-name-normalize.hh"
+#include "acmacs-virus/virus-name-tokenizer.hh"
 #include "acmacs-virus/host.hh"
 #include "acmacs-virus/passage.hh"
 #include "acmacs-virus/log.hh"
+#include "acmacs-virus/parallel.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    // std::string and fmt::memory_buffer both have append(first, last)
+    template <typename Target> static inline void append(Target& target, std::string_view text) { target.append(text.data(), text.data() + text.size()); }
+
+    // the same as acmacs::string::join(): empty components are skipped
+    template <typename Target> static inline void append_joined(Target& target, char separator, std::initializer_list<std::string_view> components)
+    {
+        bool first{true};
+        for (const auto component : components) {
+            if (!component.empty()) {
+                if (first)
+                    first = false;
+                else
+                    target.push_back(separator);
+                append(target, component);
+            }
+        }
+    }
+
+    template <typename Target> static inline void name_to(const parsed_fields_t& fields, Target& target)
+    {
+        if (fields.good())
+            append_joined(target, '/', {*fields.subtype, *fields.host, fields.location, fields.isolation, fields.year});
+        else if (fields.subtype.empty() && fields.host.empty() && fields.location.empty() && fields.isolation.empty() && fields.year.empty() && !fields.reassortant.empty() && fields.extra.empty())
+            append(target, *fields.reassortant);
+        else
+            append(target, fields.raw);
+    }
+
+    template <typename Target> static inline void full_name_to(const parsed_fields_t& fields, Target& target)
+    {
+        if (fields.good()) {
+            name_to(fields, target);
+            for (const std::string_view component : {std::string_view{*fields.reassortant}, std::string_view{fields.extra}, std::string_view{*fields.passage}}) {
+                if (!component.empty()) {
+                    target.push_back(' ');
+                    append(target, component);
+                }
+            }
+        }
+        else
+            append(target, fields.raw);
+    }
+
+} // namespace acmacs::virus::inline v2::name
 
 // ----------------------------------------------------------------------
 
 acmacs::virus::name_t acmacs::virus::name::parsed_fields_t::name() const noexcept
 {
-    if (good())
-        return name_t{acmacs::string::join(acmacs::string::join_slash, subtype, host, location, isolation, year)};
-    else if (subtype.empty() && host.empty() && location.empty() && isolation.empty() && year.empty() && !reassortant.empty() && extra.empty())
-        return name_t{*reassortant};
-    else
-        return name_t{raw};
+    std::string result;
+    name_to(result);
+    return name_t{std::move(result)};
 
 } // acmacs::virus::name::parsed_fields_t::name
 
@@ -32,15 +86,147 @@ acmacs::virus::name_t acmacs::virus::name::parsed_fields_t::name() const noexcep
 
 std::string acmacs::virus::name::parsed_fields_t::full_name() const noexcept
 {
-    if (good())
-        return acmacs::string::join(acmacs::string::join_space, name(), reassortant, extra, passage);
-    else
-        return raw;
+    std::string result;
+    full_name_to(result);
+    return result;
 
 } // acmacs::virus::name::parsed_fields_t::full_name
 
 // ----------------------------------------------------------------------
 
+void acmacs::virus::name::parsed_fields_t::name_to(std::string& target) const
+{
+    name::name_to(*this, target);
+
+} // acmacs::virus::name::parsed_fields_t::name_to
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::parsed_fields_t::name_to(fmt::memory_buffer& target) const
+{
+    name::name_to(*this, target);
+
+} // acmacs::virus::name::parsed_fields_t::name_to
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::parsed_fields_t::full_name_to(std::string& target) const
+{
+    name::full_name_to(*this, target);
+
+} // acmacs::virus::name::parsed_fields_t::full_name_to
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::parsed_fields_t::full_name_to(fmt::memory_buffer& target) const
+{
+    name::full_name_to(*this, target);
+
+} // acmacs::virus::name::parsed_fields_t::full_name_to
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::append_names(std::span<const parsed_fields_t> fields, fmt::memory_buffer& target, name_format format, char terminator)
+{
+    for (const auto& entry : fields) {
+        if (format == name_format::full_name)
+            entry.full_name_to(target);
+        else
+            entry.name_to(target);
+        target.push_back(terminator);
+    }
+
+} // acmacs::virus::name::append_names
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::write_names(std::span<const parsed_fields_t> fields, std::FILE* output, name_format format, char terminator)
+{
+    constexpr const size_t chunk_size{1 << 16};
+    fmt::memory_buffer buffer;
+    const auto flush = [&buffer, output]() {
+        if (std::fwrite(buffer.data(), 1, buffer.size(), output) != buffer.size())
+            throw std::runtime_error{fmt::format("write_names: writing failed: {}", std::strerror(errno))};
+        buffer.clear();
+    };
+    for (const auto& entry : fields) {
+        append_names(std::span{&entry, 1}, buffer, format, terminator);
+        if (buffer.size() >= chunk_size)
+            flush();
+    }
+    flush();
+
+} // acmacs::virus::name::write_names
+
+// ----------------------------------------------------------------------
+
+uint64_t acmacs::virus::name::parsed_fields_t::identity_hash(parse_fields components) const noexcept
+{
+    uint64_t hash{0xCBF29CE484222325}; // FNV-1a 64 offset basis
+    const auto add = [&hash](std::string_view component) {
+        for (const char sym : component)
+            hash = (hash ^ static_cast<unsigned char>(sym)) * 0x100000001B3; // FNV-1a 64 prime
+        hash = (hash ^ 0x1F) * 0x100000001B3; // separator: "A" + "B" and "AB" + "" differ
+    };
+
+    if (good()) {
+        if (wanted(components, parse_fields::subtype))
+            add(*subtype);
+        if (wanted(components, parse_fields::host))
+            add(*host);
+        if (wanted(components, parse_fields::location))
+            add(location);
+        if (wanted(components, parse_fields::isolation))
+            add(isolation);
+        if (wanted(components, parse_fields::year))
+            add(year);
+    }
+    else
+        add(raw);
+    if (wanted(components, parse_fields::reassortant))
+        add(*reassortant);
+    if (wanted(components, parse_fields::passage))
+        add(*passage);
+    if (wanted(components, parse_fields::extra))
+        add(extra);
+    return hash;
+
+} // acmacs::virus::name::parsed_fields_t::identity_hash
+
+// ----------------------------------------------------------------------
+
+size_t acmacs::virus::name::parsed_fields_t::number_of_messages() const noexcept
+{
+    return messages.size() + policy_messages.size();
+
+} // acmacs::virus::name::parsed_fields_t::number_of_messages
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::parsed_fields_t::clear() noexcept
+{
+    raw.clear();
+    subtype = type_subtype_t{};
+    host = interned_string_t{};
+    location.clear();
+    isolation.clear();
+    year.clear();
+    reassortant = Reassortant{};
+    passage = Passage{};
+    mutations.clear();
+    extra.clear();
+    country = interned_string_t{};
+    continent = interned_string_t{};
+    messages.clear();
+    policy_messages.clear();
+    extract_passage_ = extract_passage::yes;
+    fields_ = parse_fields::all;
+    message_policy_ = message_policy::full;
+
+} // acmacs::virus::name::parsed_fields_t::clear
+
+// ----------------------------------------------------------------------
+
 namespace acmacs::virus::inline v2::name
 {
     constexpr const std::string_view unknown_isolation{"UNKNOWN"};
@@ -60,9 +246,9 @@ namespace acmacs::virus::inline v2::name
 
     struct location_data_t
     {
-        std::string name;
-        std::string country{};
-        std::string continent{};
+        maybe_interned_string_t name{}; // plain for a chinese name
+        interned_string_t country{};
+        interned_string_t continent{};
         constexpr bool good() const { return true; }
     };
 
@@ -90,11 +276,15 @@ namespace acmacs::virus::inline v2::name
 
     // ----------------------------------------------------------------------
 
-    static void no_location_parts(std::vector<std::string_view>& parts, parsed_fields_t& output);
-    static void one_location_part(std::vector<std::string_view>& parts, location_part_t&& location_part, parsed_fields_t& output);
-    static void one_location_part_at_1(std::vector<std::string_view>& parts, parsed_fields_t& output);
-    static void one_location_part_at_2(std::vector<std::string_view>& parts, parsed_fields_t& output);
-    static void two_location_parts(std::vector<std::string_view>& parts, location_parts_t&& location_parts, parsed_fields_t& output);
+    struct classified_part_t;
+    using classified_parts_t = std::vector<classified_part_t>;
+
+    // classified is kept in sync with parts, parts inserted or modified by these functions are classified without location lookup
+    static void no_location_parts(std::vector<std::string_view>& parts, classified_parts_t& classified, parsed_fields_t& output);
+    static void one_location_part(std::vector<std::string_view>& parts, classified_parts_t& classified, location_part_t&& location_part, parsed_fields_t& output);
+    static void one_location_part_at_1(std::vector<std::string_view>& parts, classified_parts_t& classified, parsed_fields_t& output);
+    static void one_location_part_at_2(std::vector<std::string_view>& parts, classified_parts_t& classified, parsed_fields_t& output);
+    static void two_location_parts(std::vector<std::string_view>& parts, classified_parts_t& classified, location_parts_t&& location_parts, parsed_fields_t& output);
 
     enum class make_message { no, yes };
 
@@ -103,11 +293,12 @@ namespace acmacs::virus::inline v2::name
     static bool check_location(std::string_view source, parsed_fields_t& output);
     static bool check_isolation(std::string_view source, parsed_fields_t& output);
     static bool check_year(std::string_view source, parsed_fields_t& output, make_message report = make_message::yes);
-    static location_parts_t find_location_parts(std::vector<std::string_view>& parts, acmacs::messages::messages_t& messages);
+    static void find_location_parts(std::vector<std::string_view>& parts, classified_parts_t& classified, location_parts_t& location_parts, parsed_fields_t& output);
     static std::string check_reassortant_in_front(std::string_view source, parsed_fields_t& output);
     static std::string remove_reassortant_second_name(std::string_view source);
     static bool check_nibsc_extra(std::vector<std::string_view>& parts);
-    static bool location_as_prefix(std::vector<std::string_view>& parts, size_t part_to_check, parsed_fields_t& output);
+    static bool check_nibsc_extra(std::vector<std::string_view>& parts, classified_parts_t& classified);
+    static bool location_as_prefix(std::vector<std::string_view>& parts, classified_parts_t& classified, size_t part_to_check, parsed_fields_t& output);
     static void check_extra(parsed_fields_t& output);
     static bool location_part_as_isolation_prefix(std::string_view isolation, parsed_fields_t& output);
 
@@ -121,7 +312,7 @@ namespace acmacs::virus::inline v2::name
     };
     struct location_chinese_name_t : public location_data_t
     {
-        location_chinese_name_t(std::string_view nn) : location_data_t{.name = std::string{nn}} {}
+        location_chinese_name_t(std::string_view nn) : location_data_t{.name = maybe_interned_string_t{std::string{nn}}} {}
         constexpr bool good() const { return false; }
     };
 
@@ -147,6 +338,117 @@ namespace acmacs::virus::inline v2::name
 
     static location_lookup_result_t location_lookup(std::string_view source);
 
+    // location lookups made by parse_batch() for the whole batch, consulted by location_lookup() in the parsing threads
+    using resolved_locations_t = std::unordered_map<std::string_view, location_lookup_result_t>;
+    static thread_local const resolved_locations_t* resolved_locations{nullptr};
+
+    // state of parse_into() in progress in this thread that is not part of the result
+    struct parse_context_t
+    {
+        not_found_locations_t* not_found_locations{nullptr};
+        // source of parse_into() and its copy that parts refer to, the same text as raw starting at source_copy_offset
+        // (e.g. reassortant in front removed, copy is empty if it is not a part of raw)
+        std::string_view source{};
+        std::string_view source_copy{};
+        size_t source_copy_offset{0};
+    };
+
+    static thread_local parse_context_t* parse_context{nullptr};
+
+    class parse_context_guard_t
+    {
+      public:
+        parse_context_guard_t(parse_context_t& context) : previous_{parse_context} { parse_context = &context; }
+        ~parse_context_guard_t() { parse_context = previous_; }
+        parse_context_guard_t(const parse_context_guard_t&) = delete;
+        parse_context_guard_t& operator=(const parse_context_guard_t&) = delete;
+
+      private:
+        parse_context_t* previous_;
+    };
+
+    // ----------------------------------------------------------------------
+
+    // Case insensitive trie of strings looked up with location_lookup(),
+    // result of the lookup is kept in the node, so the longest location
+    // prefix of a string is found in a single walk once its prefixes were
+    // looked up. locationdb does not enumerate its names and aliases,
+    // therefore the trie is filled on demand: lookups are made without
+    // holding the lock, results are published afterwards. Queried strings
+    // are mostly junk (e.g. location with isolation), when the trie reaches
+    // max_nodes it is cleared and filled again by subsequent lookups, i.e.
+    // it caches recently used prefixes. Thread safe.
+    class location_prefix_trie_t
+    {
+      public:
+        static constexpr const size_t max_nodes{1 << 18};
+
+        // longest prefix of source found in locationdb among prefixes with size in [min_size, max_size]
+        std::optional<std::pair<size_t, location_data_t>> longest(std::string_view source, size_t min_size, size_t max_size);
+
+      private:
+        enum class state_t : uint8_t { unknown, found, not_found };
+
+        struct node_t
+        {
+            std::vector<std::pair<char, uint32_t>> children{}; // sorted by symbol
+            state_t state{state_t::unknown};
+            uint32_t location{0}; // index in locations_ for state_t::found
+        };
+
+        std::shared_mutex access_{};
+        std::vector<node_t> nodes_{node_t{}}; // root is nodes_[0]
+        std::vector<location_data_t> locations_{};
+
+        static char key(char sym) { return static_cast<char>(std::toupper(static_cast<unsigned char>(sym))); }
+        std::optional<uint32_t> child(uint32_t node, char sym) const;
+        uint32_t add_child(uint32_t node, char sym);
+    };
+
+    static location_prefix_trie_t& location_prefixes();
+
+    // ----------------------------------------------------------------------
+
+    // roles a slash separated part may play, computed once for each part before structural analysis
+    enum class part_role : uint8_t {
+        none = 0,
+        subtype = 1 << 0,   // may be accepted by check_subtype(): empty or starts with A, B or H
+        host = 1 << 1,      // is_host()
+        year = 1 << 2,      // may be accepted by check_year(): starts with 1, 2 or 4 digits
+        numeric = 1 << 3,   // digits only
+        no_digits = 1 << 4, // no digits at all
+        location = 1 << 5,  // has letters or non-ASCII symbols, i.e. may be found in locationdb
+        leading_digit = 1 << 6, // starts with a digit
+    };
+
+    constexpr part_role operator|(part_role lh, part_role rh) { return static_cast<part_role>(static_cast<uint8_t>(lh) | static_cast<uint8_t>(rh)); }
+    constexpr bool has(part_role roles, part_role role) { return (static_cast<uint8_t>(roles) & static_cast<uint8_t>(role)) != 0; }
+
+    struct classified_part_t
+    {
+        part_role roles{part_role::none};
+        std::optional<location_lookup_result_t> location{}; // location_lookup() of the part, done for part_role::location only
+    };
+
+    // parts must not be modified while classified is in use
+    static void classify_parts(const std::vector<std::string_view>& parts, classified_parts_t& classified);
+    // roles of a part without location lookup
+    static part_role part_roles(std::string_view part);
+
+    // acmacs::string::split(source, "/", acmacs::string::Split::StripRemoveEmpty) into parts, buffer of parts is reused
+    static void split_parts(std::string_view source, std::vector<std::string_view>& parts);
+
+    // buffers of parse_into() in this thread, reused by the next call
+    // (parse_into() is not reentrant), they keep their capacity, a worker
+    // parsing names in a loop does not allocate them for every name
+    struct parse_scratch_t
+    {
+        std::string source{};
+        std::vector<std::string_view> parts{};
+        classified_parts_t classified{};
+        location_parts_t location_parts{};
+    };
+
     // ----------------------------------------------------------------------
 
     // quick check to avoid calling slow (many regexp based check_reassortant_in_front)
@@ -220,6 +522,86 @@ namespace acmacs::virus::inline v2::name
         AD_LOG(acmacs::log::name_parsing, "add_extra \"{}\" <- \"{}\"", output.extra, to_add);
     }
 
+    // offset of text in raw if text is a view of raw or of a string with the same content (see parse_context_t)
+    inline std::optional<size_t> offset_in_raw(const parsed_fields_t& output, std::string_view text)
+    {
+        const auto inside = [text](std::string_view base) {
+            const std::less<const char*> less;
+            return !base.empty() && !less(text.data(), base.data()) && !less(base.data() + base.size(), text.data() + text.size());
+        };
+        if (inside(output.raw))
+            return static_cast<size_t>(text.data() - output.raw.data());
+        if (parse_context != nullptr) {
+            if (inside(parse_context->source))
+                return static_cast<size_t>(text.data() - parse_context->source.data());
+            if (inside(parse_context->source_copy))
+                return static_cast<size_t>(text.data() - parse_context->source_copy.data()) + parse_context->source_copy_offset;
+        }
+        return std::nullopt;
+    }
+
+    // refers_to: part of the raw name the message is about, text of the message is made of it, numbers and parts by make_message_text()
+    // message_policy::lazy: refers_to and parts are kept as offsets in raw, text is made (and copied) now only if any of them is not in raw
+    inline void add_message(parsed_fields_t& output, message_key key, message_format format, std::string_view refers_to, std::span<const uint32_t> numbers, std::span<const std::string_view> parts,
+                            const acmacs::messages::code_position_t& code_pos)
+    {
+        if (key == message_key::location_not_found && parse_context != nullptr && parse_context->not_found_locations != nullptr)
+            parse_context->not_found_locations->add(refers_to, output.raw);
+        if (!wanted(output.fields_, parse_fields::messages))
+            return;
+        switch (output.message_policy_) {
+            case message_policy::none:
+                break;
+            case message_policy::count:
+                output.policy_messages.count(key);
+                break;
+            case message_policy::lazy: {
+                lazy_message_t message{.key = key, .format = format, .numbers = {numbers.begin(), numbers.end()}, .code = code_pos};
+                const auto slice = [&output](std::string_view text) -> std::optional<lazy_message_t::slice_t> {
+                    if (text.empty())
+                        return lazy_message_t::slice_t{0, 0};
+                    if (const auto offset = offset_in_raw(output, text); offset.has_value())
+                        return lazy_message_t::slice_t{static_cast<uint32_t>(*offset), static_cast<uint32_t>(text.size())};
+                    return std::nullopt;
+                };
+                bool in_raw{true};
+                if (const auto refers_to_slice = slice(refers_to); refers_to_slice.has_value()) {
+                    message.offset = refers_to_slice->offset;
+                    message.length = refers_to_slice->length;
+                }
+                else
+                    in_raw = false;
+                for (auto part = parts.begin(); in_raw && part != parts.end(); ++part) {
+                    if (const auto part_slice = slice(*part); part_slice.has_value())
+                        message.parts.push_back(*part_slice);
+                    else
+                        in_raw = false;
+                }
+                if (!in_raw) {
+                    message.parts.clear();
+                    message.value = make_message_text(format, refers_to, numbers, parts, output.raw);
+                }
+                output.policy_messages.add(std::move(message));
+            } break;
+            case message_policy::full:
+                output.messages.emplace_back(to_string(key), make_message_text(format, refers_to, numbers, parts, output.raw), code_pos);
+                break;
+        }
+    }
+
+    inline void add_message(parsed_fields_t& output, message_key key, std::string_view refers_to, const acmacs::messages::code_position_t& code_pos)
+    {
+        add_message(output, key, message_format::text, refers_to, {}, {}, code_pos);
+    }
+
+    // part numbers of location parts for message_format::location_parts and message_format::location_parts_and_name
+    inline std::vector<uint32_t> part_numbers(const location_parts_t& location_parts)
+    {
+        std::vector<uint32_t> numbers(location_parts.size());
+        std::transform(location_parts.begin(), location_parts.end(), numbers.begin(), [](const auto& part) { return static_cast<uint32_t>(part.part_no); });
+        return numbers;
+    }
+
     // ----------------------------------------------------------------------
 
     inline std::tuple<acmacs::virus::mutations_t, std::string> parse_mutatations(std::string_view source)
@@ -264,48 +646,332 @@ template <> struct fmt::formatter<acmacs::virus::name::location_parts_t> : publi
 
 // ----------------------------------------------------------------------
 
-acmacs::virus::name::parsed_fields_t acmacs::virus::name::parse(std::string_view source, warn_on_empty woe, extract_passage ep)
+acmacs::virus::name::parsed_fields_t acmacs::virus::name::parse(std::string_view source, parse_fields fields, message_policy policy, warn_on_empty woe, extract_passage ep,
+                                                                not_found_locations_t* not_found_locations)
+{
+    parsed_fields_t output;
+    parse_into(source, output, fields, policy, woe, ep, not_found_locations);
+    return output;
+
+} // acmacs::virus::name::parse
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::parse_into(std::string_view source, parsed_fields_t& output, parse_fields fields, message_policy policy, warn_on_empty woe, extract_passage ep,
+                                     not_found_locations_t* not_found_locations)
 {
+    if (policy == message_policy::none)
+        fields = fields & ~parse_fields::messages;
     source = acmacs::string::strip(source);
-    parsed_fields_t output{.raw = std::string{source}, .extract_passage_ = ep};
+    output.clear();
+    output.raw.assign(source);
+    output.extract_passage_ = ep;
+    output.fields_ = fields;
+    output.message_policy_ = policy;
+    parse_context_t context{.not_found_locations = not_found_locations, .source = source};
+    const parse_context_guard_t context_guard{context};
     if (source.empty()) {
         if (woe == warn_on_empty::yes)
             AD_WARNING("empty source");
-        return output;
+        return;
     }
 
-    std::string source_s{source};
-    if (possible_reassortant_in_front(source_s))
+    thread_local parse_scratch_t scratch;
+    auto& source_s = scratch.source;
+    auto& parts = scratch.parts;
+    auto& classified = scratch.classified;
+    auto& location_parts = scratch.location_parts;
+    source_s.assign(source);
+    context.source_copy = source_s;
+    if (possible_reassortant_in_front(source_s)) {
+        context.source_copy = std::string_view{};
         source_s = check_reassortant_in_front(source_s, output);
+        if (const auto offset = source.find(source_s); offset != std::string_view::npos) { // reassortant removed from front or back, nothing changed inside
+            context.source_copy = source_s;
+            context.source_copy_offset = offset;
+        }
+    }
 
-    auto parts = acmacs::string::split(source_s, "/", acmacs::string::Split::StripRemoveEmpty);
-    auto location_parts = find_location_parts(parts, output.messages);
+    split_parts(source_s, parts);
+    classify_parts(parts, classified);
+    find_location_parts(parts, classified, location_parts, output);
     switch (location_parts.size()) {
       case 0:
-          no_location_parts(parts, output);
+          no_location_parts(parts, classified, output);
           break;
       case 1:
-          one_location_part(parts, std::move(location_parts.front()), output);
+          one_location_part(parts, classified, std::move(location_parts.front()), output);
           break;
       case 2:
-          two_location_parts(parts, std::move(location_parts), output);
+          two_location_parts(parts, classified, std::move(location_parts), output);
           break;
       default:
-          output.messages.emplace_back("multiple-location", fmt::format("{}", location_parts), MESSAGE_CODE_POSITION);
+          add_message(output, message_key::multiple_location, message_format::location_parts, source, part_numbers(location_parts), {}, MESSAGE_CODE_POSITION);
           break;
     }
 
-    check_extra(output);
+    // extra may contain reassortant, mutations, passage and subtype (e.g. "(H3N2)"), location, isolation and year are not affected
+    if (wanted(fields, parse_fields::subtype | parse_fields::reassortant | parse_fields::mutations | parse_fields::passage | parse_fields::extra | parse_fields::messages))
+        check_extra(output);
+
+    if (wanted(fields, parse_fields::messages)) {
+        if (output.good() && output.host.empty() && std::isalpha(output.isolation[0]) && is_host(output.location)) // perhaps real location and isolation are inside the same part
+            add_message(output, message_key::location_or_host, source, MESSAGE_CODE_POSITION);
+
+        if (!output.good() && output.number_of_messages() == 0)
+            add_message(output, message_key::unrecognized, source, MESSAGE_CODE_POSITION);
+    }
+
+} // acmacs::virus::name::parse_into
+
+// ----------------------------------------------------------------------
+
+bool acmacs::virus::name::is_good(std::string_view source)
+{
+    // good name has at least three parts (location, isolation, year) separated by slashes, reassortant removal never adds slashes
+    if (std::count(std::begin(source), std::end(source), '/') < 2)
+        return false;
+    // good() depends on location, isolation and year only, the decision is
+    // made by the parse() engine itself (locationdb lookups and structural
+    // hypotheses), tokenize() does not reproduce it; output buffers are
+    // reused by subsequent calls in the same thread
+    thread_local parsed_fields_t output;
+    parse_into(source, output, parse_fields::location | parse_fields::isolation | parse_fields::year, message_policy::none, warn_on_empty::no, extract_passage::no);
+    return output.good();
 
-    if (output.good() && output.host.empty() && std::isalpha(output.isolation[0]) && is_host(output.location)) // perhaps real location and isolation are inside the same part
-        output.messages.emplace_back(acmacs::messages::key::location_or_host, source, MESSAGE_CODE_POSITION);
+} // acmacs::virus::name::is_good
 
-    if (!output.good() && output.messages.empty())
-        output.messages.emplace_back(acmacs::messages::key::unrecognized, source, MESSAGE_CODE_POSITION);
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::parsed_fields_t acmacs::virus::name::parse_single_pass(std::string_view source, parse_fields fields, message_policy policy)
+{
+    if (policy == message_policy::none)
+        fields = fields & ~parse_fields::messages;
+    source = acmacs::string::strip(source);
+    parsed_fields_t output{.raw = std::string{source}, .fields_ = fields, .message_policy_ = policy};
+
+    const auto check_location_segments = [&output](std::string_view location) {
+        if (const auto segments = acmacs::string::split(location, "/", acmacs::string::Split::StripRemoveEmpty); segments.size() > 1) {
+            if (auto location_data = location_lookup(acmacs::string::join(acmacs::string::join_space, segments)); good(location_data)) // A/Lyon/CHU/R19.03.77/2019
+                set_location(output, std::move(get(location_data)));
+            else if (auto location_data_last = location_lookup(segments.back()); good(location_data_last)) // A/turkey/Bulgaria/Haskovo/336/2018
+                set_location(output, std::move(get(location_data_last)));
+            else
+                check_location(segments.front(), output);
+        }
+        else
+            check_location(location, output);
+    };
+
+    std::string_view host_or_location;  // token_type::host_or_location, decided when the location token after it is seen
+    std::string_view isolation_prefix; // rest of token_type::location_isolation after location, prepended to isolation
+    bool isolation_token{false};
+    for (const auto& token : tokenize(source)) {
+        const auto text = token.text(source);
+        switch (token.type) {
+            case token_type::subtype:
+                check_subtype(text, output);
+                break;
+            case token_type::host:
+                check_host(text, output);
+                break;
+            case token_type::host_or_location:
+                host_or_location = text;
+                break;
+            case token_type::location:
+                if (host_or_location.empty())
+                    check_location_segments(text);
+                else if (auto location_data = location_lookup(string::join(acmacs::string::join_space, host_or_location, text)); good(location_data)) // A/Lyon/CHU/R19.03.77/2019
+                    set_location(output, std::move(get(location_data)));
+                else if (good(location_lookup(host_or_location))) // location of two segments not found as a whole
+                    check_location_segments(std::string_view{host_or_location.data(), static_cast<size_t>(text.data() + text.size() - host_or_location.data())});
+                else if (check_host(host_or_location, output)) // A/wigeon/Italy/6127-23/2007
+                    check_location(text, output);
+                break;
+            case token_type::location_isolation:
+                if (auto location_data = location_lookup(text); good(location_data))
+                    set_location(output, std::move(get(location_data)));
+                else if (const auto prefix = acmacs::string::non_digit_prefix(text); prefix.size() >= 3) {
+                    if (auto found = location_prefixes().longest(prefix, 3, prefix.size()); found.has_value()) { // A/chicken/Iran221/2001 A/BiliranTB5/0423/2015
+                        set_location(output, std::move(found->second));
+                        isolation_prefix = text.substr(found->first);
+                    }
+                    else
+                        add_message(output, message_key::location_not_found, text, MESSAGE_CODE_POSITION);
+                }
+                else
+                    add_message(output, message_key::location_not_found, text, MESSAGE_CODE_POSITION);
+                break;
+            case token_type::isolation:
+                isolation_token = true;
+                if (!isolation_prefix.empty())
+                    check_isolation(string::join(acmacs::string::join_dash, isolation_prefix, text), output); // A/BiliranTB5/0423/2015 -> A/BILIRAN/TB5-0423/2015
+                else if (output.location.empty() || !output.host.empty() || std::isdigit(text[0]) || !location_part_as_isolation_prefix(text, output)) // A/Lyon/CHU18.54.48/2018
+                    check_isolation(text, output);
+                break;
+            case token_type::year:
+                check_year(text, output);
+                break;
+            case token_type::extra:
+                add_extra(output, text);
+                break;
+        }
+    }
+    if (!isolation_token && !isolation_prefix.empty()) // A/chicken/Iran221/2001
+        check_isolation(isolation_prefix, output);
+    else if (!isolation_token && !output.location.empty() && !output.year.empty()) // A/Alaska/1935
+        check_isolation(unknown_isolation, output);
+
+    if (wanted(fields, parse_fields::subtype | parse_fields::reassortant | parse_fields::mutations | parse_fields::passage | parse_fields::extra | parse_fields::messages))
+        check_extra(output);
+
+    if (wanted(fields, parse_fields::messages) && !output.good() && output.number_of_messages() == 0)
+        add_message(output, message_key::unrecognized, source, MESSAGE_CODE_POSITION);
 
     return output;
 
-} // acmacs::virus::name::parse
+} // acmacs::virus::name::parse_single_pass
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    // names are split and distinct location candidates (parts with letters) are looked up in locationdb in parallel
+    static resolved_locations_t resolve_locations(const std::vector<std::string_view>& names, size_t threads)
+    {
+        // each thread collects candidates (parts that classify_parts() looks up) into its own set, sets are merged afterwards
+        std::vector<std::unordered_set<std::string_view>> thread_candidates;
+        std::mutex thread_candidates_access;
+        detail::in_parallel(threads, names.size(), 1, [&names, &thread_candidates, &thread_candidates_access](size_t first, size_t last) {
+            std::unordered_set<std::string_view> candidates;
+            std::vector<std::string_view> parts; // reused for all names of the thread
+            for (; first < last; ++first) {
+                split_parts(names[first], parts);
+                for (const auto part : parts) {
+                    if (std::any_of(std::begin(part), std::end(part), [](char sym) { return static_cast<unsigned char>(sym) >= 0x80 || std::isalpha(sym); }))
+                        candidates.insert(part);
+                }
+            }
+            std::unique_lock lock{thread_candidates_access};
+            thread_candidates.push_back(std::move(candidates));
+        });
+        std::unordered_set<std::string_view> candidates;
+        for (auto& thread_set : thread_candidates) {
+            if (candidates.empty())
+                candidates = std::move(thread_set);
+            else
+                candidates.merge(thread_set);
+        }
+
+        const std::vector<std::string_view> to_resolve(std::begin(candidates), std::end(candidates));
+        std::vector<std::optional<location_lookup_result_t>> lookups(to_resolve.size());
+        detail::in_parallel(threads, to_resolve.size(), 1, [&to_resolve, &lookups](size_t first, size_t last) {
+            for (; first < last; ++first)
+                lookups[first] = location_lookup(to_resolve[first]);
+        });
+        resolved_locations_t resolved;
+        resolved.reserve(to_resolve.size());
+        for (size_t no = 0; no < to_resolve.size(); ++no)
+            resolved.emplace(to_resolve[no], std::move(*lookups[no]));
+        return resolved;
+    }
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+
+std::vector<acmacs::virus::name::parsed_fields_t> acmacs::virus::name::parse_batch(const std::vector<std::string_view>& names, parse_fields fields, message_policy policy,
+                                                                                 not_found_locations_t* not_found_locations, size_t threads)
+{
+    threads = detail::number_of_threads(threads);
+    const auto resolved = resolve_locations(names, threads);
+
+    // lookups of candidates are served from resolved
+    std::vector<parsed_fields_t> result(names.size());
+    detail::in_parallel(threads, names.size(), 1, [&](size_t first, size_t last) {
+        resolved_locations = &resolved;
+        for (; first < last; ++first)
+            result[first] = parse(names[first], fields, policy, warn_on_empty::no, extract_passage::yes, not_found_locations);
+        resolved_locations = nullptr;
+    });
+    return result;
+
+} // acmacs::virus::name::parse_batch
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::parse_batch(const std::vector<std::string_view>& names, parsed_columns_t& output, parse_fields fields, message_policy policy, not_found_locations_t* not_found_locations,
+                                      size_t threads)
+{
+    threads = detail::number_of_threads(threads);
+    const auto resolved = resolve_locations(names, threads);
+
+    const auto rows = names.size();
+    output.buffer.clear();
+    output.subtype.resize(rows);
+    output.host.resize(rows);
+    output.location.resize(rows);
+    output.country.resize(rows);
+    output.continent.resize(rows);
+    output.year.resize(rows);
+    output.isolation.resize(rows);
+    output.extra.resize(rows);
+    output.raw.resize(rows);
+    output.good_bits.assign((rows + 63) / 64, 0);
+    output.not_good_bits.assign((rows + 63) / 64, 0);
+
+    // each thread writes its rows (ranges are aligned to bitmap words) and
+    // collects texts in its own buffer, buffers are concatenated afterwards
+    std::vector<std::pair<size_t, std::string>> buffers; // first row, buffer
+    std::mutex buffers_access;
+    detail::in_parallel(threads, rows, 64, [&](size_t first, size_t last) {
+        resolved_locations = &resolved;
+        std::string buffer;
+        const auto add_text = [&buffer](std::string_view text) {
+            if (text.size() > std::numeric_limits<uint32_t>::max())
+                throw std::invalid_argument{fmt::format("parse_batch: text of a name is too long: {}", text.size())};
+            const parsed_columns_t::text_t result{.offset = buffer.size(), .length = static_cast<uint32_t>(text.size())};
+            buffer.append(text);
+            return result;
+        };
+        const auto id = [&output](std::string_view str) { return str.empty() ? parsed_columns_t::no_id : output.pool.intern(str); };
+        parsed_fields_t parsed; // buffers are reused for all rows of the thread
+        for (size_t row = first; row < last; ++row) {
+            parse_into(names[row], parsed, fields, policy, warn_on_empty::no, extract_passage::yes, not_found_locations);
+            output.subtype[row] = subtype_code(*parsed.subtype);
+            output.host[row] = id(*parsed.host);
+            output.location[row] = id(parsed.location);
+            output.country[row] = id(parsed.country);
+            output.continent[row] = id(parsed.continent);
+            output.year[row] = parsed.year.size() == 4 ? static_cast<uint16_t>(acmacs::string::from_chars<size_t>(parsed.year)) : uint16_t{0};
+            output.isolation[row] = add_text(parsed.isolation);
+            output.extra[row] = add_text(parsed.extra);
+            output.raw[row] = add_text(parsed.raw);
+            if (parsed.good())
+                output.good_bits[row / 64] |= uint64_t{1} << (row % 64);
+            if (parsed.not_good())
+                output.not_good_bits[row / 64] |= uint64_t{1} << (row % 64);
+        }
+        resolved_locations = nullptr;
+        std::unique_lock lock{buffers_access};
+        buffers.emplace_back(first, std::move(buffer));
+    });
+
+    std::sort(std::begin(buffers), std::end(buffers), [](const auto& b1, const auto& b2) { return b1.first < b2.first; });
+    output.buffer.reserve(std::accumulate(std::begin(buffers), std::end(buffers), size_t{0}, [](size_t sum, const auto& buf) { return sum + buf.second.size(); }));
+    for (auto it = std::begin(buffers); it != std::end(buffers); ++it) {
+        const uint64_t base{output.buffer.size()};
+        const auto last_row = std::next(it) == std::end(buffers) ? rows : std::next(it)->first;
+        for (size_t row = it->first; row < last_row; ++row) {
+            output.isolation[row].offset += base;
+            output.extra[row].offset += base;
+            output.raw[row].offset += base;
+        }
+        output.buffer.append(it->second);
+    }
+
+} // acmacs::virus::name::parse_batch
+
 
 // ----------------------------------------------------------------------
 
@@ -344,37 +1010,42 @@ acmacs::virus::name::parsed_fields_t acmacs::virus::name::parse(std::string_view
 
 // ----------------------------------------------------------------------
 
-void acmacs::virus::name::no_location_parts(std::vector<std::string_view>& parts, parsed_fields_t& output)
+void acmacs::virus::name::no_location_parts(std::vector<std::string_view>& parts, classified_parts_t& classified, parsed_fields_t& output)
 {
     AD_LOG(acmacs::log::name_parsing, "no_location_parts {}", parts);
 
     const auto set_unknown_location = [&output](std::string_view name) {
-        output.location = ::string::upper(name);
-        output.messages.emplace_back(acmacs::messages::key::location_not_found, name, MESSAGE_CODE_POSITION);
+        output.location.assign_plain(::string::upper(name));
+        add_message(output, message_key::location_not_found, name, MESSAGE_CODE_POSITION);
     };
 
     try {
         switch (parts.size()) {
             case 3:
-                if (!std::isdigit(parts[1][0]) && check_subtype(parts[0], output, make_message::no) && check_year(parts[2], output, make_message::no) && location_as_prefix(parts, 1, output))
+                // role checks are placed so that check_* functions (they may set output fields even if the whole condition fails) are called as before
+                if (!has(classified[1].roles, part_role::leading_digit) && has(classified[0].roles, part_role::subtype) && check_subtype(parts[0], output, make_message::no) &&
+                    has(classified[2].roles, part_role::year) && check_year(parts[2], output, make_message::no) && location_as_prefix(parts, classified, 1, output))
                     ; // A/Baylor1A/81
-                else if (acmacs::string::non_digit_prefix(parts[1]).size() == parts[1].size() && !is_host(parts[1]) && check_subtype(parts[0], output, make_message::no) &&
-                         check_year(parts[2], output, make_message::no) && check_isolation(unknown_isolation, output))
+                else if (has(classified[1].roles, part_role::no_digits) && !has(classified[1].roles, part_role::host) && has(classified[0].roles, part_role::subtype) &&
+                         check_subtype(parts[0], output, make_message::no) && has(classified[2].roles, part_role::year) && check_year(parts[2], output, make_message::no) &&
+                         check_isolation(unknown_isolation, output))
                     set_unknown_location(parts[1]); // A/unrecognized location/57(H2N2) -> A(H2N2)/unrecognized location/UNKNWON/1957
                 else
                     throw std::exception{};
                 break;
             case 4:
-                if ((std::isdigit(parts[2][0]) && location_as_prefix(parts, 1, output)) || location_as_prefix(parts, 2, output)) // "A/BiliranTB5/0423/2015" "A/chicken/Iran221/2001"
+                if ((has(classified[2].roles, part_role::leading_digit) && location_as_prefix(parts, classified, 1, output)) || location_as_prefix(parts, classified, 2, output)) // "A/BiliranTB5/0423/2015" "A/chicken/Iran221/2001"
                     ;
-                else if (!is_host(parts[1]) && check_subtype(parts[0], output, make_message::no) && check_isolation(parts[2], output) &&
+                else if (!has(classified[1].roles, part_role::host) && has(classified[0].roles, part_role::subtype) && check_subtype(parts[0], output, make_message::no) &&
+                         check_isolation(parts[2], output) && has(classified[3].roles, part_role::year) &&
                          check_year(parts[3], output, make_message::no)) // A/Medellin/FLU8292/2007(H3) - Medellin  is unknown location
                     set_unknown_location(parts[1]);
                 else
                     throw std::exception{};
                 break;
             case 5:
-                if (!is_host(parts[2]) && check_subtype(parts[0], output, make_message::no) && check_host(parts[1], output) && check_isolation(parts[3], output) &&
+                if (!has(classified[2].roles, part_role::host) && has(classified[0].roles, part_role::subtype) && check_subtype(parts[0], output, make_message::no) &&
+                    check_host(parts[1], output) && check_isolation(parts[3], output) && has(classified[4].roles, part_role::year) &&
                     check_year(parts[4], output, make_message::no)) // A/QUAIL/DELISERDANG/01160025/2016(H5N1) - DELISERDANG is unknown location, QUAIL is known host
                     set_unknown_location(parts[2]);
                 else
@@ -385,31 +1056,25 @@ void acmacs::virus::name::no_location_parts(std::vector<std::string_view>& parts
         }
     }
     catch (std::exception&) {
-        output.messages.emplace_back(acmacs::messages::key::location_field_not_found, acmacs::string::join(acmacs::string::join_slash, parts), MESSAGE_CODE_POSITION);
+        add_message(output, message_key::location_field_not_found, message_format::joined_parts, output.raw, {}, parts, MESSAGE_CODE_POSITION);
     }
 
 } // acmacs::virus::name::no_location_parts
 
 // ----------------------------------------------------------------------
 
-bool acmacs::virus::name::location_as_prefix(std::vector<std::string_view>& parts, size_t part_to_check, parsed_fields_t& output)
+bool acmacs::virus::name::location_as_prefix(std::vector<std::string_view>& parts, classified_parts_t& classified, size_t part_to_check, parsed_fields_t& output)
 {
-    const auto check_prefix = [&](std::string_view prefix) -> bool {
-        if (auto location_data = location_lookup(prefix); good(location_data)) { // A/Baylor1A/81
-            parts.insert(std::next(std::begin(parts), static_cast<ssize_t>(part_to_check)), prefix);
-            parts[part_to_check + 1].remove_prefix(prefix.size());
-            one_location_part(parts, location_part_t{.part_no = part_to_check, .location = get(location_data)}, output);
-            return true;
-        }
-        else
-            return false;
-    };
-
     // A/Baylor1A/81 A/BiliranTB5/0423/2015 A/FriuliVeneziaGiuliaPN/230/2019
-    // find longest prefix that can be found in the location database
-    for (auto prefix = acmacs::string::non_digit_prefix(parts[part_to_check]); prefix.size() > 2; prefix.remove_suffix(1)) {
-        if (check_prefix(prefix))
-            return true;
+    // find longest prefix (more than 2 symbols) that can be found in the location database
+    const auto prefix = acmacs::string::non_digit_prefix(parts[part_to_check]);
+    if (auto found = location_prefixes().longest(prefix, 3, prefix.size()); found.has_value()) {
+        parts.insert(std::next(std::begin(parts), static_cast<ssize_t>(part_to_check)), prefix.substr(0, found->first));
+        parts[part_to_check + 1].remove_prefix(found->first);
+        classified.insert(std::next(std::begin(classified), static_cast<ssize_t>(part_to_check)), classified_part_t{.roles = part_roles(parts[part_to_check])});
+        classified[part_to_check + 1] = classified_part_t{.roles = part_roles(parts[part_to_check + 1])};
+        one_location_part(parts, classified, location_part_t{.part_no = part_to_check, .location = std::move(found->second)}, output);
+        return true;
     }
     return false;
 
@@ -417,7 +1082,7 @@ bool acmacs::virus::name::location_as_prefix(std::vector<std::string_view>& part
 
 // ----------------------------------------------------------------------
 
-void acmacs::virus::name::one_location_part(std::vector<std::string_view>& parts, location_part_t&& location_part, parsed_fields_t& output)
+void acmacs::virus::name::one_location_part(std::vector<std::string_view>& parts, classified_parts_t& classified, location_part_t&& location_part, parsed_fields_t& output)
 {
     AD_LOG(acmacs::log::name_parsing, "ONE location part {} \"{}\" in {}", location_part.part_no, parts[location_part.part_no], parts);
 
@@ -432,13 +1097,13 @@ void acmacs::virus::name::one_location_part(std::vector<std::string_view>& parts
             //     AD_DEBUG("location in part 0 {}", parts);
             break;
         case 1:
-            one_location_part_at_1(parts, output);
+            one_location_part_at_1(parts, classified, output);
             break;
         case 2:
-            one_location_part_at_2(parts, output);
+            one_location_part_at_2(parts, classified, output);
             break;
         default:
-            output.messages.emplace_back("unexpected-location-part", fmt::format("{} {}", location_part.part_no, parts), MESSAGE_CODE_POSITION);
+            add_message(output, message_key::unexpected_location_part, message_format::numbered_parts, output.raw, std::array{static_cast<uint32_t>(location_part.part_no)}, parts, MESSAGE_CODE_POSITION);
             break;
     }
 
@@ -446,8 +1111,9 @@ void acmacs::virus::name::one_location_part(std::vector<std::string_view>& parts
 
 // ----------------------------------------------------------------------
 
-void acmacs::virus::name::one_location_part_at_1(std::vector<std::string_view>& parts, parsed_fields_t& output)
+void acmacs::virus::name::one_location_part_at_1(std::vector<std::string_view>& parts, classified_parts_t& classified, parsed_fields_t& output)
 {
+    // roles of parts are used before checks made without messages, check_* calls making messages are kept to report rejected parts
     try {
         AD_LOG(acmacs::log::name_parsing, "ONE location part at 1 and {} parts: {}", parts.size(), parts);
         switch (parts.size()) {
@@ -458,12 +1124,12 @@ void acmacs::virus::name::one_location_part_at_1(std::vector<std::string_view>&
             case 4: // A/Germany/1/2014
                 if (!check_subtype(parts[0], output) || !check_year(parts[3], output))
                     throw std::exception{};
-                if (!location_part_as_isolation_prefix(parts[2], output) // A/Lyon/CHU18.54.48/2018
+                if ((has(classified[2].roles, part_role::leading_digit) || !location_part_as_isolation_prefix(parts[2], output)) // A/Lyon/CHU18.54.48/2018
                     && !check_isolation(parts[2], output))
                     throw std::exception{};
                 break;
             case 5:
-                if (check_year(parts[4], output, make_message::no)) {
+                if (has(classified[4].roles, part_role::year) && check_year(parts[4], output, make_message::no)) {
                     if (auto location_data = location_lookup(string::join(acmacs::string::join_space, parts[1], parts[2])); good(location_data)) { // A/Lyon/CHU/R19.03.77/2019
                         set_location(output, std::move(get(location_data)));
                         if (!check_subtype(parts[0], output) || !check_isolation(parts[3], output)) // A/Algeria/G0164/15/2015 :h1n1
@@ -472,9 +1138,9 @@ void acmacs::virus::name::one_location_part_at_1(std::vector<std::string_view>&
                     else if (!check_subtype(parts[0], output) || !check_isolation(string::join(acmacs::string::join_dash, parts[2], parts[3]), output)) // A/Algeria/G0164/15/2015 :h1n1
                         throw std::exception{};
                 }
-                else if (check_nibsc_extra(parts) && parts.size() == 4 /* check_nibsc_extra removed last part */) { // "A/Beijing/2019-15554/2018  CNIC-1902  (19/148)"
+                else if (check_nibsc_extra(parts, classified) && parts.size() == 4 /* check_nibsc_extra removed last part */) { // "A/Beijing/2019-15554/2018  CNIC-1902  (19/148)"
                     // AD_DEBUG("nisbc extra {}", parts);
-                    one_location_part_at_1(parts, output);
+                    one_location_part_at_1(parts, classified, output);
                 }
                 else if (!check_subtype(parts[0], output) || !check_isolation(parts[2], output) || !check_year(parts[3], output))
                     throw std::exception{};
@@ -496,7 +1162,7 @@ void acmacs::virus::name::one_location_part_at_1(std::vector<std::string_view>&
         }
     }
     catch (std::exception&) {
-        output.messages.emplace_back("unexpected-location-part", fmt::format("1 {}", parts), MESSAGE_CODE_POSITION);
+        add_message(output, message_key::unexpected_location_part, message_format::numbered_parts, output.raw, std::array{uint32_t{1}}, parts, MESSAGE_CODE_POSITION);
     }
 
 } // acmacs::virus::name::one_location_part_at_1
@@ -505,24 +1171,32 @@ void acmacs::virus::name::one_location_part_at_1(std::vector<std::string_view>&
 
 bool acmacs::virus::name::location_part_as_isolation_prefix(std::string_view isolation, parsed_fields_t& output)
 {
-    if (std::isdigit(isolation[0]))
+    // isolation starting with a digit is rejected by the caller (part_role::leading_digit)
+
+    // prefix (more than 2 symbols, shorter than isolation) combined with location or, if location is a host, prefix alone
+    // longest prefix wins, combined wins if both are of the same size
+    const auto prefix = acmacs::string::non_digit_prefix(isolation);
+    if (prefix.size() < 3 || prefix.size() == isolation.size())
         return false;
 
-    for (auto prefix = acmacs::string::non_digit_prefix(isolation); prefix.size() > 2 && prefix.size() < isolation.size(); prefix.remove_suffix(1)) {
-        // AD_DEBUG("location_part_as_isolation_prefix \"{}\" + \"{}\"", output.location, prefix);
-        if (auto location_data_combined = location_lookup(fmt::format("{} {}", output.location, prefix)); good(location_data_combined)) { // "LYON CHU" <- A/Lyon/CHU19.03.77/2019
-            set_location(output, std::move(get(location_data_combined)));
-            check_isolation(isolation.substr(prefix.size()), output);
+    fmt::memory_buffer combined_buffer; // inline storage, not allocated for names of usual length
+    fmt::format_to(std::back_inserter(combined_buffer), "{} {}", output.location, prefix);
+    const std::string_view combined{combined_buffer.data(), combined_buffer.size()};
+    const auto combined_prefix_size = output.location.size() + 1;
+    auto found_combined = location_prefixes().longest(combined, combined_prefix_size + 3, combined.size());                 // "LYON CHU" <- A/Lyon/CHU19.03.77/2019
+    const auto combined_size = found_combined.has_value() ? found_combined->first - combined_prefix_size : size_t{0};
+    if (output.host.empty() && is_host(output.location)) {
+        if (auto found = location_prefixes().longest(prefix, std::max(combined_size + 1, size_t{3}), prefix.size()); found.has_value()) { // "A/turkey/Italy12rs206-2/1999(H7N1)" -> A/Turkey/Italy/12rs206-2/1999(H7N1)
+            check_host(output.location, output);
+            set_location(output, std::move(found->second));
+            check_isolation(isolation.substr(found->first), output);
             return true;
         }
-        else if (output.host.empty() && is_host(output.location)) {
-            if (auto location_data_isolation = location_lookup(prefix); good(location_data_isolation)) { // "A/turkey/Italy12rs206-2/1999(H7N1)" -> A/Turkey/Italy/12rs206-2/1999(H7N1)
-                check_host(output.location, output);
-                set_location(output, std::move(get(location_data_isolation)));
-                check_isolation(isolation.substr(prefix.size()), output);
-                return true;
-            }
-        }
+    }
+    if (found_combined.has_value()) {
+        set_location(output, std::move(found_combined->second));
+        check_isolation(isolation.substr(combined_size), output);
+        return true;
     }
 
     return false;
@@ -531,8 +1205,9 @@ bool acmacs::virus::name::location_part_as_isolation_prefix(std::string_view iso
 
 // ----------------------------------------------------------------------
 
-void acmacs::virus::name::one_location_part_at_2(std::vector<std::string_view>& parts, parsed_fields_t& output)
+void acmacs::virus::name::one_location_part_at_2(std::vector<std::string_view>& parts, classified_parts_t& classified, parsed_fields_t& output)
 {
+    // see one_location_part_at_1() for use of roles
     try {
         // AD_DEBUG("one_location_part_at_2: {}", parts);
         switch (parts.size()) {
@@ -545,7 +1220,7 @@ void acmacs::virus::name::one_location_part_at_2(std::vector<std::string_view>&
                     throw std::exception{};
                 break;
             case 6:
-                if (check_year(parts[5], output, make_message::no)) {
+                if (has(classified[5].roles, part_role::year) && check_year(parts[5], output, make_message::no)) {
                     if (auto location_data = location_lookup(string::join(acmacs::string::join_space, parts[2], parts[3])); good(location_data)) { // A/swine/Lyon/CHU/R19.03.77/2019
                         set_location(output, std::move(get(location_data)));
                         if (!check_subtype(parts[0], output) || !check_host(parts[1], output) || !check_isolation(parts[4], output))
@@ -555,8 +1230,8 @@ void acmacs::virus::name::one_location_part_at_2(std::vector<std::string_view>&
                              !check_isolation(string::join(acmacs::string::join_dash, parts[3], parts[4]), output)) // A/chicken/CentralJava/Solo/VSN331/2013
                         throw std::exception{};
                 }
-                else if (check_nibsc_extra(parts) && parts.size() == 5 /* check_nibsc_extra removed last part */) { // A/duck/Vietnam/NCVD1584/2012 NIBRG-301 (18/134)
-                    one_location_part_at_2(parts, output);
+                else if (check_nibsc_extra(parts, classified) && parts.size() == 5 /* check_nibsc_extra removed last part */) { // A/duck/Vietnam/NCVD1584/2012 NIBRG-301 (18/134)
+                    one_location_part_at_2(parts, classified, output);
                 }
                 else
                     throw std::exception{};
@@ -566,39 +1241,44 @@ void acmacs::virus::name::one_location_part_at_2(std::vector<std::string_view>&
         }
     }
     catch (std::exception&) {
-        output.messages.emplace_back("unexpected-location-part", fmt::format("2 {}", parts), MESSAGE_CODE_POSITION);
+        add_message(output, message_key::unexpected_location_part, message_format::numbered_parts, output.raw, std::array{uint32_t{2}}, parts, MESSAGE_CODE_POSITION);
     }
 
 } // acmacs::virus::name::one_location_part_at_2
 
 // ----------------------------------------------------------------------
 
-void acmacs::virus::name::two_location_parts(std::vector<std::string_view>& parts, location_parts_t&& location_parts, parsed_fields_t& output)
+void acmacs::virus::name::two_location_parts(std::vector<std::string_view>& parts, classified_parts_t& classified, location_parts_t&& location_parts, parsed_fields_t& output)
 {
     AD_LOG(acmacs::log::name_parsing, "TWO location part {}", parts);
 
     const auto double_location = [&](const acmacs::messages::code_position_t& code_pos) {
-        output.messages.emplace_back("double-location", fmt::format("{} \"{}\"", location_parts, acmacs::string::join(acmacs::string::join_slash, parts)), code_pos);
+        add_message(output, message_key::double_location, message_format::location_parts_and_name, output.raw, part_numbers(location_parts), parts, code_pos);
+    };
+
+    const auto erase_part = [&parts, &classified](size_t part_no) {
+        parts.erase(std::next(parts.begin(), static_cast<ssize_t>(part_no)));
+        classified.erase(std::next(classified.begin(), static_cast<ssize_t>(part_no)));
     };
 
     if ((location_parts[0].part_no + 1) != location_parts[1].part_no) {
         double_location(MESSAGE_CODE_POSITION);
     }
-    else if (is_host(parts[location_parts.front().part_no])) {
-        one_location_part(parts, std::move(location_parts[1]), output);
+    else if (has(classified[location_parts.front().part_no].roles, part_role::host)) {
+        one_location_part(parts, classified, std::move(location_parts[1]), output);
     }
     else if (location_parts[0].location.name == location_parts[1].location.country) { // A/India/Delhi/DB106/2009 -> A/Delhi/DB106/2009
-        parts.erase(std::next(parts.begin(), static_cast<ssize_t>(location_parts[0].part_no)));
-        one_location_part(parts, {location_parts[1].part_no - 1, std::move(location_parts[1].location)}, output);
+        erase_part(location_parts[0].part_no);
+        one_location_part(parts, classified, {location_parts[1].part_no - 1, std::move(location_parts[1].location)}, output);
     }
     else if (location_parts[0].location.country == location_parts[1].location.name) { // A/Cologne/Germany/01/2009 -> A/Cologne/01/2009
-        parts.erase(std::next(parts.begin(), static_cast<ssize_t>(location_parts[1].part_no)));
-        one_location_part(parts, std::move(location_parts[0]), output);
+        erase_part(location_parts[1].part_no);
+        one_location_part(parts, classified, std::move(location_parts[0]), output);
     }
     else if (location_parts[0].location.country == location_parts[1].location.country) { // "B/Mount_Lebanon/Ain_W_zein/3/2019" -> "B/Mount Lebanon Ain W zein/3/2019"
         check_location(string::join(acmacs::string::join_space, location_parts[0].location.name, location_parts[1].location.name), output);
-        parts.erase(std::next(parts.begin(), static_cast<ssize_t>(location_parts[1].part_no)));
-        one_location_part(parts, location_part_t{.part_no=location_parts[0].part_no}, output);
+        erase_part(location_parts[1].part_no);
+        one_location_part(parts, classified, location_part_t{.part_no=location_parts[0].part_no}, output);
     }
     else
         double_location(MESSAGE_CODE_POSITION);
@@ -684,7 +1364,7 @@ bool acmacs::virus::name::check_subtype(std::string_view source, parsed_fields_t
     catch (std::exception&) {
         // AD_ERROR("invalid_subtype \"{}\"", source);
         if (report == make_message::yes)
-            output.messages.emplace_back(acmacs::messages::key::invalid_subtype, source, MESSAGE_CODE_POSITION);
+            add_message(output, message_key::invalid_subtype, source, MESSAGE_CODE_POSITION);
         return false;
     }
 
@@ -696,8 +1376,8 @@ bool acmacs::virus::name::check_host(std::string_view source, parsed_fields_t& o
 {
     using namespace std::string_view_literals;
     if (source.size() >= 4 && source.substr(0, 4) == "TEST"sv)
-        output.messages.emplace_back(acmacs::messages::key::invalid_host, source, MESSAGE_CODE_POSITION);
-    output.host = host_t{fix_host(::string::remove(source, "'\""))};
+        add_message(output, message_key::invalid_host, source, MESSAGE_CODE_POSITION);
+    output.host = interned_string_t{fix_host(::string::remove(source, "'\""))};
     return true;
 
 } // acmacs::virus::name::check_host
@@ -708,12 +1388,16 @@ acmacs::virus::name::location_lookup_result_t acmacs::virus::name::location_look
 {
     using namespace std::string_view_literals;
 
-    const auto upcased{::string::upper(source)};
-    if (upcased == "UNKNOWN"sv)
+    if (resolved_locations != nullptr) {
+        if (const auto found = resolved_locations->find(source); found != resolved_locations->end())
+            return found->second;
+    }
+
+    if (acmacs::string::equals_ignore_case(source, "UNKNOWN"sv))
         return location_not_found_t{source};
 
     if (const auto loc = acmacs::locationdb::get().find(source, acmacs::locationdb::include_continent::yes); loc.has_value())
-        return location_data_t{.name{loc->name}, .country{std::string{loc->country()}}, .continent{loc->continent}};
+        return location_data_t{.name = interned_string_t{loc->name}, .country = interned_string_t{loc->country()}, .continent = interned_string_t{loc->continent}};
 
     // https://www.shabsin.com/~rshabsin/chineseutf8chars.html
     if (static_cast<unsigned char>(source[0]) >= 0xE3 && static_cast<unsigned char>(source[0]) < 0xEA) // chinese or possibly chinese symbol
@@ -726,9 +1410,9 @@ acmacs::virus::name::location_lookup_result_t acmacs::virus::name::location_look
     };
 
     for (const auto& [e1, e2] : common_abbreviations) {
-        if (e1 == upcased) {
+        if (acmacs::string::equals_ignore_case(source, e1)) {
             if (const auto loc = acmacs::locationdb::get().find(e2, acmacs::locationdb::include_continent::yes); loc.has_value())
-                return location_data_t{.name{loc->name}, .country{std::string{loc->country()}}, .continent{loc->continent}};
+                return location_data_t{.name = interned_string_t{loc->name}, .country = interned_string_t{loc->country()}, .continent = interned_string_t{loc->continent}};
         }
     }
 
@@ -738,6 +1422,130 @@ acmacs::virus::name::location_lookup_result_t acmacs::virus::name::location_look
 
 // ----------------------------------------------------------------------
 
+acmacs::virus::name::location_prefix_trie_t& acmacs::virus::name::location_prefixes()
+{
+#include "acmacs-base/global-constructors-push.hh"
+    static location_prefix_trie_t trie;
+#include "acmacs-base/diagnostics-pop.hh"
+    return trie;
+
+} // acmacs::virus::name::location_prefixes
+
+// ----------------------------------------------------------------------
+
+std::optional<uint32_t> acmacs::virus::name::location_prefix_trie_t::child(uint32_t node, char sym) const
+{
+    const auto& children = nodes_[node].children;
+    if (const auto found = std::lower_bound(std::begin(children), std::end(children), sym, [](const auto& entry, char sm) { return entry.first < sm; });
+        found != std::end(children) && found->first == sym)
+        return found->second;
+    return std::nullopt;
+
+} // acmacs::virus::name::location_prefix_trie_t::child
+
+// ----------------------------------------------------------------------
+
+uint32_t acmacs::virus::name::location_prefix_trie_t::add_child(uint32_t node, char sym)
+{
+    if (const auto existing = child(node, sym); existing.has_value())
+        return *existing;
+    const auto new_node = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    auto& children = nodes_[node].children;
+    children.emplace(std::lower_bound(std::begin(children), std::end(children), sym, [](const auto& entry, char sm) { return entry.first < sm; }), sym, new_node);
+    return new_node;
+
+} // acmacs::virus::name::location_prefix_trie_t::add_child
+
+// ----------------------------------------------------------------------
+
+std::optional<std::pair<size_t, acmacs::virus::name::location_data_t>> acmacs::virus::name::location_prefix_trie_t::longest(std::string_view source, size_t min_size, size_t max_size)
+{
+    max_size = std::min(max_size, source.size());
+    if (min_size > max_size)
+        return std::nullopt;
+
+    {
+        // fast path: walk existing nodes, the answer is the longest prefix in range which is not known to be absent in locationdb
+        std::shared_lock lock{access_};
+        std::optional<std::pair<size_t, uint32_t>> candidate; // prefix size, node
+        uint32_t node{0};
+        size_t size{0};
+        for (; size < max_size; ++size) {
+            if (const auto next = child(node, key(source[size])); next.has_value())
+                node = *next;
+            else
+                break;
+            if ((size + 1) >= min_size && nodes_[node].state != state_t::not_found)
+                candidate = std::pair{size + 1, node};
+        }
+        if (size == max_size) {
+            if (!candidate.has_value())
+                return std::nullopt;
+            if (const auto& found = nodes_[candidate->second]; found.state == state_t::found)
+                return std::pair{candidate->first, locations_[found.location]};
+        }
+    }
+
+    // slow path: states of prefixes known so far, copy of the longest found one
+    std::vector<state_t> states(max_size + 1, state_t::unknown);
+    std::optional<std::pair<size_t, location_data_t>> found;
+    {
+        std::shared_lock lock{access_};
+        uint32_t node{0};
+        for (size_t size = 0; size < max_size; ++size) {
+            if (const auto next = child(node, key(source[size])); next.has_value())
+                node = *next;
+            else
+                break;
+            states[size + 1] = nodes_[node].state;
+            if (states[size + 1] == state_t::found && (size + 1) >= min_size)
+                found = std::pair{size + 1, locations_[nodes_[node].location]};
+        }
+    }
+
+    // look up unknown prefixes longer than the found one, longest first, without holding the lock
+    std::vector<std::pair<size_t, location_lookup_result_t>> looked_up;
+    for (size_t size = max_size; size >= min_size && (!found.has_value() || size > found->first); --size) {
+        if (states[size] == state_t::unknown) {
+            auto& [looked_up_size, result] = looked_up.emplace_back(size, location_lookup(source.substr(0, size)));
+            if (good(result)) {
+                found = std::pair{looked_up_size, get(result)};
+                break;
+            }
+        }
+        if (size == 0)
+            break;
+    }
+
+    // publish results of the lookups
+    if (!looked_up.empty()) {
+        std::unique_lock lock{access_};
+        if ((nodes_.size() + max_size) > max_nodes) { // full: start over, buffers keep their capacity
+            nodes_.assign(1, node_t{});
+            locations_.clear();
+        }
+        std::vector<uint32_t> path(max_size + 1, 0);
+        for (size_t size = 0; size < max_size; ++size)
+            path[size + 1] = add_child(path[size], key(source[size]));
+        for (auto& [size, result] : looked_up) {
+            if (auto& node = nodes_[path[size]]; node.state == state_t::unknown) { // may be published by another thread in the meantime
+                if (good(result)) {
+                    node.state = state_t::found;
+                    node.location = static_cast<uint32_t>(locations_.size());
+                    locations_.push_back(std::move(get(result)));
+                }
+                else
+                    node.state = state_t::not_found;
+            }
+        }
+    }
+    return found;
+
+} // acmacs::virus::name::location_prefix_trie_t::longest
+
+// ----------------------------------------------------------------------
+
 bool acmacs::virus::name::check_location(std::string_view source, parsed_fields_t& output)
 {
     if (auto loc_enc = location_lookup(source); good(loc_enc)) {
@@ -748,7 +1556,7 @@ bool acmacs::virus::name::check_location(std::string_view source, parsed_fields_
         return true;
     }
     else {
-        output.messages.emplace_back(acmacs::messages::key::location_not_found, source, MESSAGE_CODE_POSITION);
+        add_message(output, message_key::location_not_found, source, MESSAGE_CODE_POSITION);
         return false;
     }
 
@@ -756,34 +1564,120 @@ bool acmacs::virus::name::check_location(std::string_view source, parsed_fields_
 
 // ----------------------------------------------------------------------
 
-acmacs::virus::name::location_parts_t acmacs::virus::name::find_location_parts(std::vector<std::string_view>& parts, acmacs::messages::messages_t& messages)
+acmacs::virus::name::part_role acmacs::virus::name::part_roles(std::string_view part)
+{
+    enum symbol_class : uint8_t { other = 0, digit = 1, letter = 2, non_ascii = 4 };
+    static constexpr const auto symbol_classes = []() {
+        std::array<uint8_t, 256> table{};
+        for (size_t sym = 0; sym < table.size(); ++sym) {
+            if (sym >= '0' && sym <= '9')
+                table[sym] = digit;
+            else if ((sym >= 'A' && sym <= 'Z') || (sym >= 'a' && sym <= 'z'))
+                table[sym] = letter;
+            else if (sym >= 0x80)
+                table[sym] = non_ascii;
+        }
+        return table;
+    }();
+    const auto symbol_class = [](char sym) { return symbol_classes[static_cast<unsigned char>(sym)]; };
+
+    part_role roles{part_role::none};
+    uint8_t classes{other};
+    size_t leading_digits{0};
+    for (size_t pos = 0; pos < part.size(); ++pos) {
+        const auto sym_class = symbol_class(part[pos]);
+        if (sym_class == digit && leading_digits == pos)
+            ++leading_digits;
+        classes |= sym_class;
+    }
+    if (part.empty())
+        roles = roles | part_role::subtype;
+    else {
+        switch (std::toupper(part[0])) {
+            case 'A':
+            case 'B':
+            case 'H':
+                roles = roles | part_role::subtype;
+                break;
+        }
+    }
+    if (leading_digits > 0)
+        roles = roles | part_role::leading_digit;
+    if (leading_digits == 1 || leading_digits == 2 || leading_digits == 4)
+        roles = roles | part_role::year;
+    if (!part.empty() && classes == digit)
+        roles = roles | part_role::numeric;
+    if ((classes & digit) == 0)
+        roles = roles | part_role::no_digits;
+    if ((classes & (letter | non_ascii)) != 0) {
+        roles = roles | part_role::location;
+        if (is_host(part))
+            roles = roles | part_role::host;
+    }
+    return roles;
+
+} // acmacs::virus::name::part_roles
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::classify_parts(const std::vector<std::string_view>& parts, classified_parts_t& classified)
+{
+    classified.clear();
+    classified.resize(parts.size());
+    for (size_t part_no = 0; part_no < parts.size(); ++part_no) {
+        classified[part_no].roles = part_roles(parts[part_no]);
+        if (has(classified[part_no].roles, part_role::location))
+            classified[part_no].location = location_lookup(parts[part_no]);
+    }
+
+} // acmacs::virus::name::classify_parts
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::split_parts(std::string_view source, std::vector<std::string_view>& parts)
 {
-    location_parts_t location_parts;
+    parts.clear();
+    for (size_t first = 0; first <= source.size();) {
+        const auto last = std::min(source.find('/', first), source.size());
+        if (const auto part = acmacs::string::strip(source.substr(first, last - first)); !part.empty())
+            parts.push_back(part);
+        first = last + 1;
+    }
+
+} // acmacs::virus::name::split_parts
+
+// ----------------------------------------------------------------------
+
+void acmacs::virus::name::find_location_parts(std::vector<std::string_view>& parts, classified_parts_t& classified, location_parts_t& location_parts, parsed_fields_t& output)
+{
+    location_parts.clear();
     for (size_t part_no = 0; part_no < parts.size(); ++part_no) {
+        if (!classified[part_no].location.has_value()) // cannot be a location
+            continue;
         std::visit(
-            [&location_parts, part_no, &messages]<typename Arg>(Arg&& arg) {
+            [&location_parts, part_no, &output]<typename Arg>(Arg&& arg) {
                 if constexpr (std::is_same_v<location_data_t, std::decay_t<Arg>>) {
                     location_parts.push_back({part_no, arg});
                 }
                 else if constexpr (std::is_same_v<location_chinese_name_t, std::decay_t<Arg>>) {
                     location_parts.push_back({part_no, arg});
-                    messages.emplace_back(acmacs::messages::key::location_not_found, arg.name);
+                    add_message(output, message_key::location_not_found, arg.name, MESSAGE_CODE_POSITION);
                 }
             },
-            location_lookup(parts[part_no]));
+            std::move(*classified[part_no].location));
     }
 
     // if just one location part found, it is in place 0 or 1, next part starts with a letter, this location is perhaps a host (e.g. TURKEY)
     if (location_parts.size() == 1 && location_parts[0].part_no < 2 && location_parts[0].part_no < (parts.size() - 1) && is_host(location_parts[0].location.name)) {
-        if (acmacs::string::non_digit_prefix(parts[location_parts[0].part_no + 1]).size() == parts[location_parts[0].part_no + 1].size())
-            return {}; // location is most probably next part, but locdb cannot detect it
+        if (has(classified[location_parts[0].part_no + 1].roles, part_role::no_digits)) {
+            location_parts.clear(); // location is most probably next part, but locdb cannot detect it
+            return;
+        }
     }
 
     if (location_parts.size() > 2 && is_host(location_parts[0].location.name)) // A/Turkey/Bulgaria/Haskovo/336/2018
         location_parts.erase(location_parts.begin());
 
-    return location_parts;
-
 } // acmacs::virus::name::find_location_parts
 
 // ----------------------------------------------------------------------
@@ -792,17 +1686,19 @@ bool acmacs::virus::name::check_isolation(std::string_view source, parsed_fields
 {
     using namespace std::string_view_literals;
     // AD_DEBUG("check_isolation \"{}\"", source);
-    if (const auto skip_spaces_zeros = source.find_first_not_of(" 0"sv); skip_spaces_zeros != std::string_view::npos)
-        output.isolation = ::string::upper(source.substr(skip_spaces_zeros));
+    if (const auto skip_spaces_zeros = source.find_first_not_of(" 0"sv); skip_spaces_zeros != std::string_view::npos) {
+        output.isolation.assign(source.substr(skip_spaces_zeros));
+        std::transform(output.isolation.begin(), output.isolation.end(), output.isolation.begin(), [](char sym) { return static_cast<char>(std::toupper(static_cast<unsigned char>(sym))); });
+    }
     if (output.isolation.size() > 3 && output.isolation.substr(output.isolation.size() - 3) == "_HA") // isolation ending with _HA means HA segment in sequences from ncbi
         output.isolation.erase(output.isolation.size() - 3);
     if (output.isolation.empty()) {
         if (!source.empty()) {
-            output.isolation = source;
+            output.isolation.assign(source);
             // output.messages.emplace_back(acmacs::messages::key::invalid_isolation, source, MESSAGE_CODE_POSITION);
         }
         else
-            output.messages.emplace_back(acmacs::messages::key::isolation_absent, source, MESSAGE_CODE_POSITION);
+            add_message(output, message_key::isolation_absent, source, MESSAGE_CODE_POSITION);
     }
     else
         ::string::replace_in_place(output.isolation, '_', ' ');
@@ -821,6 +1717,10 @@ bool acmacs::virus::name::check_year(std::string_view source, parsed_fields_t& o
 
     const auto digits = acmacs::string::digit_prefix(source);
     AD_LOG(acmacs::log::name_parsing, "check_year digits: \"{}\" <- \"{}\"", digits, source);
+    const auto set_year = [&output](size_t year) {
+        output.year.clear(); // buffer of output is reused, see parse_into()
+        fmt::format_to(std::back_inserter(output.year), "{}", year);
+    };
 
     try {
         if (paren_match(source) < 0) // e.g. last part in "A/Beijing/2019-15554/2018  CNIC-1902  (19/148)"
@@ -829,15 +1729,15 @@ bool acmacs::virus::name::check_year(std::string_view source, parsed_fields_t& o
             case 1:
             case 2:
                 if (const auto year = acmacs::string::from_chars<size_t>(digits); year <= current_year_2)
-                    output.year = fmt::format("{}", year + 2000);
+                    set_year(year + 2000);
                 else if (year < 100) // from_chars returns std::numeric_limits<size_t>::max() if number cannot be read
-                    output.year = fmt::format("{}", year + 1900);
+                    set_year(year + 1900);
                 else
                     throw std::exception{};
                 break;
             case 4:
                 if (const auto year = acmacs::string::from_chars<size_t>(digits); year <= current_year)
-                    output.year = fmt::format("{}", year);
+                    set_year(year);
                 else
                     throw std::exception{};
                 break;
@@ -851,7 +1751,7 @@ bool acmacs::virus::name::check_year(std::string_view source, parsed_fields_t& o
     catch (std::exception&) {
         // AD_LOG(acmacs::log::name_parsing, "check_year ERROR in \"{}\" digits:\"{}\" digits-size:{}", source, digits, digits.size());
         if (report == make_message::yes)
-            output.messages.emplace_back(acmacs::messages::key::invalid_year, fmt::format("\"{}\" <- \"{}\"", source, output.raw), MESSAGE_CODE_POSITION);
+            add_message(output, message_key::invalid_year, message_format::invalid_year, source, {}, {}, MESSAGE_CODE_POSITION);
         return false;
     }
 
@@ -896,7 +1796,7 @@ std::string acmacs::virus::name::check_reassortant_in_front(std::string_view sou
     }
 
     if (result.empty() && !output.reassortant.empty())
-        output.messages.emplace_back(acmacs::messages::key::reassortant_without_name, source, MESSAGE_CODE_POSITION);
+        add_message(output, message_key::reassortant_without_name, source, MESSAGE_CODE_POSITION);
 
     // AD_DEBUG("check_reassortant_in_front \"{}\" -> \"{}\" R:\"{}\"", source, result, *output.reassortant);
 
@@ -977,6 +1877,20 @@ bool acmacs::virus::name::check_nibsc_extra(std::vector<std::string_view>& parts
 
 // ----------------------------------------------------------------------
 
+bool acmacs::virus::name::check_nibsc_extra(std::vector<std::string_view>& parts, classified_parts_t& classified)
+{
+    if (!check_nibsc_extra(parts))
+        return false;
+    // the last two parts were modified, the last one perhaps removed
+    classified.resize(parts.size());
+    for (size_t part_no = parts.size() > 1 ? parts.size() - 2 : 0; part_no < parts.size(); ++part_no)
+        classified[part_no] = classified_part_t{.roles = part_roles(parts[part_no])};
+    return true;
+
+} // acmacs::virus::name::check_nibsc_extra
+
+// ----------------------------------------------------------------------
+
 void acmacs::virus::name::check_extra(parsed_fields_t& output)
 {
     using namespace acmacs::regex;
@@ -985,21 +1899,31 @@ void acmacs::virus::name::check_extra(parsed_fields_t& output)
     if (!output.extra.empty()) {
         AD_LOG_INDENT;
 
-        if (!output.extra.empty() && output.reassortant.empty()) {
+        // stages that cannot contribute to the wanted fields are skipped, each stage works on extra left by the previous ones
+        const auto wanted_field = [&output](parse_fields field) { return wanted(output.fields_, field); };
+        const bool normalize_stage = wanted_field(parse_fields::extra) || (wanted_field(parse_fields::subtype | parse_fields::messages) && output.subtype == type_subtype_t{"A"});
+        const bool passage_stage = normalize_stage || wanted_field(parse_fields::passage);
+        const bool mutations_stage = passage_stage || wanted_field(parse_fields::mutations);
+        const bool reassortant_stage = mutations_stage || wanted_field(parse_fields::reassortant);
+
+        if (reassortant_stage && !output.extra.empty() && output.reassortant.empty()) {
             std::tie(output.reassortant, output.extra) = parse_reassortant(output.extra);
             AD_LOG(acmacs::log::name_parsing, "check_extra after extracting reassortant \"{}\"", output.extra);
         }
 
-        if (!output.extra.empty() && output.mutations.empty()) {
+        if (mutations_stage && !output.extra.empty() && output.mutations.empty()) {
             std::tie(output.mutations, output.extra) = parse_mutatations(output.extra);
             AD_LOG(acmacs::log::name_parsing, "check_extra after extracting mutations \"{}\"", output.extra);
         }
 
-        if (!output.extra.empty() && output.passage.empty() && output.extract_passage_ == extract_passage::yes) {
+        if (passage_stage && !output.extra.empty() && output.passage.empty() && output.extract_passage_ == extract_passage::yes) {
             std::tie(output.passage, output.extra) = parse_passage(output.extra, passage_only::no);
             AD_LOG(acmacs::log::name_parsing, "check_extra after extracting passage \"{}\"", output.extra);
         }
 
+        if (!normalize_stage)
+            return;
+
 #include "acmacs-base/global-constructors-push.hh"
         static const std::array normalize_data{
             look_replace_t{std::regex("(?:"
@@ -1057,6 +1981,28 @@ void acmacs::virus::name::check_extra(parsed_fields_t& output)
 
 } // acmacs::virus::name::check_extra
 
+// ----------------------------------------------------------------------
+
+// compile function local static regexes, called by acmacs::virus::init()
+namespace acmacs::virus::inline v2::detail
+{
+    void init_name_subtype() { normalize_a_subtype("H3N2"); }
+
+    void init_name_mutations() { name::parse_mutatations({}); }
+
+    void init_name_reassortant() { name::remove_reassortant_second_name({}); }
+
+    void init_name_extra()
+    {
+        name::parsed_fields_t output{.raw = "X", .extra = "X"};
+        name::check_extra(output);
+        name::check_year("2000", output, name::make_message::no);
+        std::vector<std::string_view> parts{"A (", "1)"};
+        name::check_nibsc_extra(parts);
+    }
+
+} // namespace acmacs::virus::inline v2::detail
+
 // ----------------------------------------------------------------------
 /// Local Variables:
 /// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdio>
+
 #include "acmacs-virus/virus-name.hh"
 #include "acmacs-virus/parsing-message.hh"
+#include "acmacs-virus/virus-name-columns.hh"
 
 // ----------------------------------------------------------------------
 
@@ -10,12 +13,34 @@ namespace acmacs::virus::inline v2::name
     enum class warn_on_empty { no, yes };
     enum class extract_passage { no, yes };
 
+    // fields wanted from parse(), work that contributes only to other fields is skipped, other fields may be left empty
+    enum class parse_fields : unsigned {
+        none = 0,
+        subtype = 1 << 0,
+        host = 1 << 1,
+        location = 1 << 2, // including country and continent
+        isolation = 1 << 3,
+        year = 1 << 4,
+        reassortant = 1 << 5,
+        passage = 1 << 6,
+        mutations = 1 << 7,
+        extra = 1 << 8,
+        messages = 1 << 9,
+        name = subtype | host | location | isolation | year,
+        all = name | reassortant | passage | mutations | extra | messages
+    };
+
+    constexpr parse_fields operator|(parse_fields lh, parse_fields rh) { return static_cast<parse_fields>(static_cast<unsigned>(lh) | static_cast<unsigned>(rh)); }
+    constexpr parse_fields operator&(parse_fields lh, parse_fields rh) { return static_cast<parse_fields>(static_cast<unsigned>(lh) & static_cast<unsigned>(rh)); }
+    constexpr parse_fields operator~(parse_fields fields) { return static_cast<parse_fields>(~static_cast<unsigned>(fields)) & parse_fields::all; }
+    constexpr bool wanted(parse_fields fields, parse_fields field) { return (fields & field) != parse_fields::none; }
+
     struct parsed_fields_t
     {
         std::string raw;
         type_subtype_t subtype{};
-        host_t host{};
-        std::string location{};
+        interned_string_t host{}; // hosts and locations found in locationdb are in interned_strings()
+        maybe_interned_string_t location{}; // plain if not found in locationdb
         std::string isolation{};
         std::string year{};
         Reassortant reassortant{};
@@ -23,11 +48,14 @@ namespace acmacs::virus::inline v2::name
         mutations_t mutations{};
         // aa_substitutions
         std::string extra{};
-        std::string country{};
-        std::string continent{};
+        interned_string_t country{}; // country and continent come from locationdb only, they are in interned_strings()
+        interned_string_t continent{};
         acmacs::messages::messages_t messages{};
+        policy_messages_t policy_messages{}; // message_policy::count and message_policy::lazy
 
         extract_passage extract_passage_{extract_passage::yes};
+        parse_fields fields_{parse_fields::all};
+        message_policy message_policy_{message_policy::full};
 
         bool good() const noexcept { return !location.empty() && !isolation.empty() && year.size() == 4; }
         bool good_but_no_country() const noexcept { return good() && country.empty(); }
@@ -35,12 +63,85 @@ namespace acmacs::virus::inline v2::name
         bool reassortant_only() const { return location.empty() && isolation.empty() && year.empty() && !reassortant.empty(); }
         name_t name() const noexcept;
         std::string full_name() const noexcept;
+        // name() and full_name() appended to target, no temporary strings are made
+        void name_to(std::string& target) const;
+        void name_to(fmt::memory_buffer& target) const;
+        void full_name_to(std::string& target) const;
+        void full_name_to(fmt::memory_buffer& target) const;
+        // Canonical hash of the virus identity: FNV-1a of components (name
+        // fields, reassortant, passage, extra) as they are after
+        // normalization, i.e. the same for differently spelled raw names of
+        // the same virus, in every process and on every platform. Raw name
+        // is hashed if parsing was not good (name() is raw name then too).
+        uint64_t identity_hash(parse_fields components = parse_fields::name | parse_fields::reassortant) const noexcept;
+        size_t number_of_messages() const noexcept;
+        const message_counts_t& message_counts() const noexcept { return policy_messages.counts(); } // message_policy::count
+        std::span<const lazy_message_t> lazy_messages() const noexcept { return policy_messages.lazy(); } // message_policy::lazy
+        // empties all fields and resets options to defaults, capacities of strings and vectors are kept
+        void clear() noexcept;
     };
 
-    parsed_fields_t parse(std::string_view source, warn_on_empty woe = warn_on_empty::yes, extract_passage ep = extract_passage::yes);
+    // fields not in the "fields" mask may be left empty, fields in the mask are the same as in the full parse
+    // parse_fields::messages is ignored if policy is message_policy::none
+    parsed_fields_t parse(std::string_view source, parse_fields fields, message_policy policy, warn_on_empty woe = warn_on_empty::yes, extract_passage ep = extract_passage::yes,
+                          not_found_locations_t* not_found_locations = nullptr);
+    inline parsed_fields_t parse(std::string_view source, parse_fields fields, warn_on_empty woe = warn_on_empty::yes, extract_passage ep = extract_passage::yes) { return parse(source, fields, message_policy::full, woe, ep); }
+    inline parsed_fields_t parse(std::string_view source, message_policy policy, warn_on_empty woe = warn_on_empty::yes, extract_passage ep = extract_passage::yes) { return parse(source, parse_fields::all, policy, woe, ep); }
+    inline parsed_fields_t parse(std::string_view source, warn_on_empty woe = warn_on_empty::yes, extract_passage ep = extract_passage::yes) { return parse(source, parse_fields::all, message_policy::full, woe, ep); }
+    // locations not found in locationdb are added to not_found_locations regardless of message policy
+    inline parsed_fields_t parse(std::string_view source, not_found_locations_t& not_found_locations, parse_fields fields = parse_fields::all, message_policy policy = message_policy::full,
+                                 warn_on_empty woe = warn_on_empty::yes, extract_passage ep = extract_passage::yes)
+    {
+        return parse(source, fields, policy, woe, ep, &not_found_locations);
+    }
+    // Same as parse() but the result is written into output, which is
+    // cleared first: buffers of output are reused, a worker parsing names in
+    // a loop into the same object does not reallocate them for every name.
+    void parse_into(std::string_view source, parsed_fields_t& output, parse_fields fields = parse_fields::all, message_policy policy = message_policy::full, warn_on_empty woe = warn_on_empty::yes,
+                    extract_passage ep = extract_passage::yes, not_found_locations_t* not_found_locations = nullptr);
     // std::vector<std::string> possible_locations_in_name(std::string_view source);
 
-    inline bool is_good(std::string_view source) { return parse(source, warn_on_empty::no).good(); }
+    // same as parse(source).good(), but no messages are made, reassortant,
+    // passage and extra are not extracted and the thread's output buffers
+    // are reused. It is a projection of parse(), not a separate validator:
+    // a verdict that always agrees with parse() needs its location lookups.
+    bool is_good(std::string_view source);
+
+    // Alternative engine: tokenize() (virus-name-tokenizer.hh) and check
+    // each token once, no structural hypotheses are tried. parse() is the
+    // reference, test-virus-name --diff reports where they diverge. Not
+    // handled:
+    //  - reassortant in front of the name (IVR-153 (A/CALIFORNIA/07/2009),
+    //    A/reassortant/IDCDC-RG22(New York/18/2009 x ...))
+    //  - parts are typed by position: host/location/year without isolation
+    //    is taken as location/isolation/year, isolation of several parts
+    //    (A/Zambia/13/174/2013) is reduced to the last one
+    //  - location not found in locationdb is rejected, not kept as unknown
+    //  - NIBSC/NYMC "(year/number)" suffix is not removed
+    // test_builtin() in test-virus-name.cc lists builtin names that diverge
+    // for these reasons, any other divergence there is an error.
+    parsed_fields_t parse_single_pass(std::string_view source, parse_fields fields = parse_fields::all, message_policy policy = message_policy::full);
+
+    enum class name_format { name, full_name };
+
+    // name() or full_name() of each element of fields followed by terminator
+    void append_names(std::span<const parsed_fields_t> fields, fmt::memory_buffer& target, name_format format = name_format::full_name, char terminator = '\n');
+    // the same written to output in chunks, throws std::runtime_error if writing fails
+    void write_names(std::span<const parsed_fields_t> fields, std::FILE* output, name_format format = name_format::full_name, char terminator = '\n');
+
+    // Parses names in two stages: names are split and distinct location
+    // candidates (parts with letters) of the whole batch are looked up in
+    // locationdb once, in parallel, then names are parsed in parallel with
+    // lookups of those candidates served from the batch results.
+    // Result is in the order of names. threads: 0 - hardware concurrency.
+    std::vector<parsed_fields_t> parse_batch(const std::vector<std::string_view>& names, parse_fields fields = parse_fields::all, message_policy policy = message_policy::full,
+                                             not_found_locations_t* not_found_locations = nullptr, size_t threads = 0);
+
+    // Same as above, but results are written into columns as each name is
+    // parsed, parsed_fields_t of the whole batch are not kept. Previous
+    // content of output columns is replaced, strings interned in the pool are kept.
+    void parse_batch(const std::vector<std::string_view>& names, parsed_columns_t& output, parse_fields fields = parse_fields::name | parse_fields::extra,
+                     message_policy policy = message_policy::none, not_found_locations_t* not_found_locations = nullptr, size_t threads = 0);
 
 } // namespace acmacs::virus::inline v2
 
@@ -0,0 +1,111 @@
+#include <thread>
+#include <chrono>
+#include <numeric>
+#include <unistd.h>
+
+#include "acmacs-base/argv.hh"
+#include "acmacs-base/read-file.hh"
+#include "acmacs-base/string-split.hh"
+#include "acmacs-virus/service-io.hh"
+
+// ----------------------------------------------------------------------
+// Test client for virus-name-service: sends names over the unix domain
+// socket from several concurrent connections and reports latency.
+// ----------------------------------------------------------------------
+
+using namespace acmacs::argv;
+struct Options : public argv
+{
+    Options(int a_argc, const char* const a_argv[], on_error on_err = on_error::exit) : argv() { parse(a_argc, a_argv, on_err); }
+
+    option<str> socket_path{*this, 's', "socket", desc{"unix domain socket virus-name-service listens on"}};
+    option<str> from_file{*this, 'f', "from", desc{"read names from file (one per line)"}};
+    option<size_t> connections{*this, 'c', "connections", dflt<size_t>{1}, desc{"number of concurrent connections"}};
+    option<size_t> repeat{*this, 'r', "repeat", dflt<size_t>{1}, desc{"send each name that many times per connection"}};
+    option<bool> length_prefixed{*this, 'l', "length-prefixed", desc{"requests and responses are prefixed with 4 byte (big endian) length instead of being newline delimited"}};
+    option<bool> print_responses{*this, 'p', "print", desc{"print responses (first connection only)"}};
+
+    argument<str_array> names{*this, arg_name{"name"}};
+};
+
+using duration_t = std::chrono::duration<double, std::micro>;
+
+// ----------------------------------------------------------------------
+
+int main(int argc, const char* const* argv)
+{
+    using namespace acmacs::virus::service;
+
+    int exit_code = 0;
+    try {
+        Options opt(argc, argv);
+        if (!opt.socket_path)
+            throw std::runtime_error{fmt::format("Usage: {} -s <socket> [-f <filename>] [<name> ...]", argv[0])};
+
+        std::string file_data;
+        std::vector<std::string_view> names;
+        if (opt.from_file) {
+            file_data = acmacs::file::read(opt.from_file);
+            names = acmacs::string::split(file_data, "\n", acmacs::string::Split::RemoveEmpty);
+        }
+        for (const auto& name : opt.names)
+            names.push_back(name);
+        if (names.empty())
+            throw std::runtime_error{"no names to send"};
+
+        const auto frm = opt.length_prefixed ? framing::length_prefixed : framing::newline;
+        std::vector<std::vector<duration_t>> latencies(opt.connections);
+        std::vector<std::thread> clients;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t connection_no = 0; connection_no < *opt.connections; ++connection_no) {
+            clients.emplace_back([&, connection_no]() {
+                const int fd = connect(opt.socket_path);
+                fd_writer_t output{fd, frm};
+                fd_reader_t input{fd, frm};
+                auto& latency = latencies[connection_no];
+                latency.reserve(names.size() * opt.repeat);
+                for (size_t rep = 0; rep < *opt.repeat; ++rep) {
+                    for (const auto& name : names) {
+                        const auto sent = std::chrono::steady_clock::now();
+                        if (!output.write(name))
+                            break;
+                        const auto response = input.next();
+                        if (!response.has_value())
+                            break;
+                        latency.push_back(std::chrono::steady_clock::now() - sent);
+                        if (opt.print_responses && connection_no == 0 && rep == 0)
+                            fmt::print("{}\n", *response);
+                    }
+                }
+                ::close(fd);
+            });
+        }
+        for (auto& client : clients)
+            client.join();
+        const duration_t elapsed = std::chrono::steady_clock::now() - start;
+
+        std::vector<duration_t> all;
+        for (const auto& latency : latencies)
+            all.insert(all.end(), latency.begin(), latency.end());
+        if (all.empty())
+            throw std::runtime_error{"no responses received"};
+        std::sort(all.begin(), all.end());
+        const auto percentile = [&all](double pc) { return all[std::min(all.size() - 1, static_cast<size_t>(static_cast<double>(all.size()) * pc))].count(); };
+        const auto total = std::accumulate(all.begin(), all.end(), duration_t{0});
+        fmt::print(stderr, "Requests:    {:8d} ({} connections)\nElapsed:     {:8.3f} s\nThroughput:  {:8.0f} req/s\nLatency (us): mean {:.1f}  min {:.1f}  p50 {:.1f}  p95 {:.1f}  p99 {:.1f}  max {:.1f}\n",
+                   all.size(), *opt.connections, elapsed.count() / 1e6, static_cast<double>(all.size()) / (elapsed.count() / 1e6), total.count() / static_cast<double>(all.size()),
+                   all.front().count(), percentile(0.5), percentile(0.95), percentile(0.99), all.back().count());
+        if (all.size() != (names.size() * *opt.repeat * *opt.connections))
+            throw std::runtime_error{fmt::format("{} responses expected, {} received", names.size() * *opt.repeat * *opt.connections, all.size())};
+    }
+    catch (std::exception& err) {
+        fmt::print(stderr, "ERROR: {}\n", err);
+        exit_code = 1;
+    }
+    return exit_code;
+}
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
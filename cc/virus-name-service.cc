@@ -0,0 +1,408 @@
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <deque>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+
+#include "acmacs-base/argv.hh"
+#include "acmacs-virus/log.hh"
+#include "acmacs-virus/virus-name-normalize.hh"
+#include "acmacs-virus/init.hh"
+#include "acmacs-virus/service-io.hh"
+
+// ----------------------------------------------------------------------
+// Long-lived virus name parser: regexes are compiled and locationdb is
+// loaded once, then requests (one virus name each) are answered from a
+// thread pool either over a unix domain socket or as a stdio co-process.
+// Request framing: newline-delimited (default) or length-prefixed (4 bytes, big endian).
+// Response: one line/frame per request, tab separated:
+//   name full-name subtype host location isolation year reassortant passage extra country continent message-keys
+// ----------------------------------------------------------------------
+
+using namespace acmacs::argv;
+struct Options : public argv
+{
+    Options(int a_argc, const char* const a_argv[], on_error on_err = on_error::exit) : argv() { parse(a_argc, a_argv, on_err); }
+
+    option<str> socket_path{*this, 's', "socket", desc{"listen on unix domain socket (otherwise read requests from stdin and write responses to stdout)"}};
+    option<size_t> threads{*this, 't', "threads", dflt<size_t>{0}, desc{"number of worker threads, 0 - hardware concurrency"}};
+    option<bool> length_prefixed{*this, 'l', "length-prefixed", desc{"requests and responses are prefixed with 4 byte (big endian) length instead of being newline delimited"}};
+    option<str_array> verbose{*this, 'v', "verbose", desc{"comma separated list (or multiple switches) of log enablers"}};
+};
+
+// ----------------------------------------------------------------------
+
+class thread_pool_t
+{
+  public:
+    thread_pool_t(size_t threads)
+    {
+        if (threads == 0)
+            threads = std::max(std::thread::hardware_concurrency(), 1u);
+        for (size_t th = 0; th < threads; ++th)
+            workers_.emplace_back([this] { run(); });
+    }
+
+    ~thread_pool_t()
+    {
+        {
+            std::unique_lock lock{mutex_};
+            stop_ = true;
+        }
+        condition_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    template <typename F> auto submit(F&& func)
+    {
+        using result_t = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(func));
+        auto result = task->get_future();
+        {
+            std::unique_lock lock{mutex_};
+            tasks_.emplace_back([task]() { (*task)(); });
+        }
+        condition_.notify_one();
+        return result;
+    }
+
+    size_t size() const { return workers_.size(); }
+
+  private:
+    std::vector<std::thread> workers_{};
+    std::deque<std::function<void()>> tasks_{};
+    std::mutex mutex_{};
+    std::condition_variable condition_{};
+    bool stop_{false};
+
+    void run()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock{mutex_};
+                condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (stop_ && tasks_.empty())
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+// ----------------------------------------------------------------------
+
+static std::string respond(std::string_view request);
+static void serve_stdio(thread_pool_t& pool, acmacs::virus::service::framing framing);
+static void serve_socket(std::string_view socket_path, thread_pool_t& pool, acmacs::virus::service::framing framing);
+
+static volatile std::sig_atomic_t sStop{0};
+
+// ----------------------------------------------------------------------
+
+int main(int argc, const char* const* argv)
+{
+    int exit_code = 0;
+    try {
+        Options opt(argc, argv);
+        acmacs::log::enable(opt.verbose);
+        std::signal(SIGPIPE, SIG_IGN);
+        AD_INFO("{}", acmacs::virus::init()); // compile regexes and load locationdb before the first request arrives
+        thread_pool_t pool{opt.threads};
+        const auto framing = opt.length_prefixed ? acmacs::virus::service::framing::length_prefixed : acmacs::virus::service::framing::newline;
+        if (opt.socket_path)
+            serve_socket(opt.socket_path, pool, framing);
+        else
+            serve_stdio(pool, framing);
+    }
+    catch (std::exception& err) {
+        AD_ERROR("{}", err);
+        exit_code = 1;
+    }
+    return exit_code;
+}
+
+// ----------------------------------------------------------------------
+
+std::string respond(std::string_view request)
+{
+    // only message keys are reported, message values are not formatted
+    const auto fields = acmacs::virus::name::parse(request, acmacs::virus::name::message_policy::lazy, acmacs::virus::name::warn_on_empty::no);
+    std::string message_keys;
+    for (const auto& msg : fields.lazy_messages()) {
+        if (!message_keys.empty())
+            message_keys.append(1, ',');
+        message_keys.append(to_string(msg.key));
+    }
+    return fmt::format("{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}", fields.name(), fields.full_name(), fields.subtype, fields.host, fields.location, fields.isolation, fields.year, fields.reassortant,
+                       fields.passage, fields.extra, fields.country, fields.continent, message_keys);
+
+} // respond
+
+// ----------------------------------------------------------------------
+
+void serve_stdio(thread_pool_t& pool, acmacs::virus::service::framing framing)
+{
+    // requests are parsed concurrently, responses are written in the order of requests
+    std::deque<std::future<std::string>> pending;
+    std::mutex pending_mutex;
+    std::condition_variable pending_cv;
+    bool input_done{false};
+
+    std::thread writer{[&]() {
+        acmacs::virus::service::fd_writer_t output{STDOUT_FILENO, framing};
+        while (true) {
+            std::future<std::string> response;
+            {
+                std::unique_lock lock{pending_mutex};
+                pending_cv.wait(lock, [&] { return input_done || !pending.empty(); });
+                if (pending.empty())
+                    break;
+                response = std::move(pending.front());
+                pending.pop_front();
+            }
+            if (!output.write(response.get()))
+                break;
+        }
+    }};
+
+    acmacs::virus::service::fd_reader_t input{STDIN_FILENO, framing};
+    while (const auto request = input.next()) {
+        {
+            std::unique_lock lock{pending_mutex};
+            pending.push_back(pool.submit([request = *request]() { return respond(request); }));
+        }
+        pending_cv.notify_one();
+    }
+    if (input.frame_too_large())
+        AD_ERROR("request larger than {} bytes, input ignored from that point", acmacs::virus::service::fd_reader_t::default_max_frame_size);
+    {
+        std::unique_lock lock{pending_mutex};
+        input_done = true;
+    }
+    pending_cv.notify_one();
+    writer.join();
+
+} // serve_stdio
+
+// ----------------------------------------------------------------------
+
+// Wakes the polling thread of serve_socket() up when a worker queued a
+// response: a byte is written to a pipe polled together with connections.
+class wakeup_t
+{
+  public:
+    wakeup_t()
+    {
+        if (::pipe(fds_.data()) < 0)
+            throw acmacs::virus::Error{fmt::format("pipe: {}", std::strerror(errno))};
+        acmacs::virus::service::set_non_blocking(fds_[0]);
+        acmacs::virus::service::set_non_blocking(fds_[1]);
+    }
+    wakeup_t(const wakeup_t&) = delete;
+    wakeup_t& operator=(const wakeup_t&) = delete;
+    ~wakeup_t()
+    {
+        ::close(fds_[0]);
+        ::close(fds_[1]);
+    }
+
+    int fd() const { return fds_[0]; }
+
+    void notify() // pipe full: polling thread has not yet drained previous notifications, nothing is lost
+    {
+        const char byte{0};
+        [[maybe_unused]] const auto written = ::write(fds_[1], &byte, 1);
+    }
+
+    void drain()
+    {
+        std::array<char, 256> data;
+        while (::read(fds_[0], data.data(), data.size()) > 0)
+            ;
+    }
+
+  private:
+    std::array<int, 2> fds_{-1, -1};
+};
+
+// ----------------------------------------------------------------------
+
+// Connection of serve_socket(), its fd is non-blocking: requests are read
+// by the polling thread and parsed by pool workers, workers queue
+// responses in the order of requests, the polling thread writes them when
+// fd is writable. Requests are not read while too many are in flight or
+// too much output is queued (client does not read responses).
+class connection_t
+{
+  public:
+    static constexpr const size_t max_in_flight{256};
+    static constexpr const size_t max_queued_output{1 << 20};
+
+    // fd must be non-blocking
+    connection_t(int fd, acmacs::virus::service::framing framing, std::shared_ptr<wakeup_t> wakeup) : fd_{fd}, input_{fd, framing}, output_{fd, framing}, wakeup_{std::move(wakeup)} {}
+    connection_t(const connection_t&) = delete;
+    connection_t& operator=(const connection_t&) = delete;
+    ~connection_t() { ::close(fd_); } // the last reference is released by the polling thread or by a worker queuing a response to a dropped connection
+
+    int fd() const { return fd_; }
+    acmacs::virus::service::fd_reader_t& input() { return input_; } // polling thread only
+    size_t next_request_no() { return next_request_++; }             // polling thread only
+    void input_closed() { input_closed_ = true; }                    // polling thread only
+
+    // worker
+    void respond(size_t request_no, std::string&& response)
+    {
+        {
+            std::unique_lock lock{output_access_};
+            ready_.emplace(request_no, std::move(response));
+            for (auto first = ready_.begin(); first != ready_.end() && first->first == next_response_; first = ready_.erase(first), ++next_response_)
+                output_.queue(first->second);
+        }
+        wakeup_->notify();
+    }
+
+    // polling thread: events to poll for, input while under the limits, output while it is queued
+    short events()
+    {
+        std::unique_lock lock{output_access_};
+        short result{0};
+        if (!input_closed_ && (next_request_ - next_response_) < max_in_flight && output_.queued() < max_queued_output)
+            result |= POLLIN;
+        if (output_.queued() > 0)
+            result |= POLLOUT;
+        return result;
+    }
+
+    // polling thread, returns false on error
+    bool flush()
+    {
+        std::unique_lock lock{output_access_};
+        return output_.flush();
+    }
+
+    // polling thread: input closed and all responses written
+    bool done()
+    {
+        std::unique_lock lock{output_access_};
+        return input_closed_ && next_response_ == next_request_ && output_.queued() == 0;
+    }
+
+  private:
+    int fd_;
+    acmacs::virus::service::fd_reader_t input_;
+    size_t next_request_{0};
+    bool input_closed_{false};
+    std::mutex output_access_{};
+    acmacs::virus::service::fd_writer_t output_;
+    size_t next_response_{0};
+    std::map<size_t, std::string> ready_{}; // responses to queue after responses to previous requests
+    std::shared_ptr<wakeup_t> wakeup_;
+};
+
+void serve_socket(std::string_view socket_path, thread_pool_t& pool, acmacs::virus::service::framing framing)
+{
+    const auto listener = acmacs::virus::service::listen(socket_path);
+    auto wakeup = std::make_shared<wakeup_t>();
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = [](int) { sStop = 1; };
+    sigaction(SIGINT, &action, nullptr); // no SA_RESTART: poll() is interrupted
+    sigaction(SIGTERM, &action, nullptr);
+
+    // one thread polls the listener and all connections, each request is
+    // handed to the pool, workers are never blocked on connections
+    AD_INFO("virus-name-service: listening on {} with {} threads", socket_path, pool.size());
+    std::vector<std::shared_ptr<connection_t>> connections;
+    std::vector<pollfd> poll_fds;
+    constexpr const size_t first_connection{2}; // poll_fds: listener, wakeup, connections
+    while (!sStop) {
+        poll_fds.clear();
+        poll_fds.push_back(pollfd{.fd = listener, .events = POLLIN, .revents = 0});
+        poll_fds.push_back(pollfd{.fd = wakeup->fd(), .events = POLLIN, .revents = 0});
+        for (const auto& connection : connections)
+            poll_fds.push_back(pollfd{.fd = connection->fd(), .events = connection->events(), .revents = 0});
+        if (::poll(poll_fds.data(), poll_fds.size(), 500) < 0) { // timeout: sStop is checked even if signal arrived before poll()
+            if (errno == EINTR)
+                continue;
+            AD_ERROR("poll: {}", std::strerror(errno));
+            break;
+        }
+        if (poll_fds[1].revents & POLLIN)
+            wakeup->drain(); // events of connections with newly queued responses are updated in the next iteration
+
+        for (size_t conn_no = 0; conn_no < connections.size(); ++conn_no) {
+            auto& connection = connections[conn_no];
+            const auto revents = poll_fds[conn_no + first_connection].revents;
+            if (revents & POLLIN) {
+                auto& input = connection->input();
+                const bool open = input.fill();
+                while (auto request = input.extract(!open))
+                    pool.submit([connection, request_no = connection->next_request_no(), request = std::move(*request)]() { connection->respond(request_no, respond(request)); });
+                if (input.frame_too_large()) {
+                    AD_WARNING("virus-name-service: request larger than {} bytes, connection closed", acmacs::virus::service::fd_reader_t::default_max_frame_size);
+                    ::shutdown(connection->fd(), SHUT_RDWR);
+                    connection.reset();
+                    continue;
+                }
+                if (!open)
+                    connection->input_closed(); // removed when pending responses are written
+            }
+            else if (revents & (POLLHUP | POLLERR | POLLNVAL)) { // peer is gone, input is not polled or nothing to read
+                connection.reset();
+                continue;
+            }
+            if ((revents & POLLOUT) && !connection->flush()) {
+                connection.reset();
+                continue;
+            }
+            if (connection->done())
+                connection.reset();
+        }
+        connections.erase(std::remove(connections.begin(), connections.end(), nullptr), connections.end());
+
+        if (poll_fds.front().revents & POLLIN) {
+            if (const int fd = ::accept(listener, nullptr, nullptr); fd >= 0) {
+                try {
+                    acmacs::virus::service::set_non_blocking(fd);
+                }
+                catch (std::exception& err) {
+                    AD_ERROR("virus-name-service: {}", err);
+                    ::close(fd);
+                    continue;
+                }
+                connections.push_back(std::make_shared<connection_t>(fd, framing, wakeup));
+            }
+            else if (errno != EINTR)
+                AD_ERROR("accept: {}", std::strerror(errno));
+        }
+    }
+
+    // pending responses are dropped, connections are closed when workers release them
+    for (const auto& connection : connections)
+        ::shutdown(connection->fd(), SHUT_RDWR);
+    connections.clear();
+    ::close(listener);
+    ::unlink(std::string{socket_path}.c_str());
+
+} // serve_socket
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -0,0 +1,180 @@
+#include <array>
+#include <algorithm>
+#include <cctype>
+
+#include "acmacs-virus/virus-name-tokenizer.hh"
+#include "acmacs-virus/host.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    struct segment_t
+    {
+        size_t first;
+        size_t last; // past the end
+    };
+
+    constexpr const size_t max_segments{16};
+
+    inline size_t leading_digits(std::string_view source)
+    {
+        size_t digits{0};
+        while (digits < source.size() && std::isdigit(source[digits]))
+            ++digits;
+        return digits;
+    }
+
+    inline bool has_digits(std::string_view source)
+    {
+        return std::any_of(source.begin(), source.end(), [](char sym) { return std::isdigit(sym); });
+    }
+
+    // Iran221, BiliranTB5, Mali 071 Ci
+    inline bool location_isolation_like(std::string_view source)
+    {
+        return !std::isdigit(source[0]) && has_digits(source);
+    }
+
+    inline bool year_like(std::string_view source)
+    {
+        const auto digits = leading_digits(source);
+        return digits == 1 || digits == 2 || digits == 4;
+    }
+
+    // A, B, A(H3N2), AH3N2, A(H1N1)PDM09
+    inline bool subtype_like(std::string_view source)
+    {
+        switch (std::toupper(source[0])) {
+            case 'A':
+                return source.size() == 1 || source[1] == '(' || std::toupper(source[1]) == 'H';
+            case 'B':
+                return source.size() == 1;
+            default:
+                return false;
+        }
+    }
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+
+acmacs::virus::name::tokens_t acmacs::virus::name::tokenize(std::string_view source)
+{
+    std::array<segment_t, max_segments> segments;
+    size_t num_segments{0};
+
+    // spaces around segment are not part of it, empty segments are ignored, too many segments: the rest goes to the last one
+    const auto add_segment = [&](size_t first, size_t last) {
+        while (first < last && std::isspace(source[first]))
+            ++first;
+        while (last > first && std::isspace(source[last - 1]))
+            --last;
+        if (first == last)
+            return;
+        if (num_segments < max_segments)
+            segments[num_segments++] = segment_t{first, last};
+        else
+            segments[max_segments - 1].last = last;
+    };
+
+    size_t paren_level{0}, segment_start{0};
+    for (size_t pos = 0; pos < source.size(); ++pos) {
+        switch (source[pos]) {
+            case '(':
+                ++paren_level;
+                break;
+            case ')':
+                if (paren_level > 0)
+                    --paren_level;
+                break;
+            case '/':
+                if (paren_level == 0) {
+                    add_segment(segment_start, pos);
+                    segment_start = pos + 1;
+                }
+                break;
+        }
+    }
+    add_segment(segment_start, source.size());
+
+    // ----------------------------------------------------------------------
+
+    tokens_t tokens;
+    if (num_segments == 0)
+        return tokens;
+    tokens.reserve(num_segments + 1);
+    const auto segment = [&](size_t no) { return source.substr(segments[no].first, segments[no].last - segments[no].first); };
+    const auto add = [&](token_type type, size_t first, size_t last) { tokens.push_back(token_t{type, static_cast<uint32_t>(first), static_cast<uint32_t>(last - first)}); };
+    const auto add_segments = [&](token_type type, size_t first_segment, size_t last_segment) { add(type, segments[first_segment].first, segments[last_segment].last); };
+
+    // year is the last year-like segment preceded by at least one segment
+    size_t year_segment{0};
+    for (size_t no = num_segments - 1; no > 0; --no) {
+        if (year_like(segment(no))) {
+            year_segment = no;
+            break;
+        }
+    }
+
+    size_t first{0};
+    if (subtype_like(segment(0)) && (year_segment == 0 || year_segment > 1)) {
+        add_segments(token_type::subtype, 0, 0);
+        first = 1;
+    }
+    if (year_segment == 0) { // no year, name is not recognized
+        if (first < num_segments)
+            add_segments(token_type::extra, first, num_segments - 1);
+        return tokens;
+    }
+
+    switch (year_segment - first) {
+        case 0:
+            break;
+        case 1:
+            add_segments(location_isolation_like(segment(first)) ? token_type::location_isolation : token_type::location, first, first);
+            break;
+        case 2:
+            if (is_host(segment(first)) && location_isolation_like(segment(first + 1))) { // A/chicken/Iran221/2001
+                add_segments(token_type::host, first, first);
+                add_segments(token_type::location_isolation, first + 1, first + 1);
+            }
+            else {
+                const bool isolation_in_location = location_isolation_like(segment(first)) && std::isdigit(segment(first + 1)[0]); // A/BiliranTB5/0423/2015
+                add_segments(isolation_in_location ? token_type::location_isolation : token_type::location, first, first);
+                add_segments(token_type::isolation, first + 1, first + 1);
+            }
+            break;
+        default:
+            if (is_host(segment(first))) {
+                add_segments(token_type::host, first, first);
+                ++first;
+            }
+            else if ((year_segment - first) == 3 && !has_digits(segment(first)) && !has_digits(segment(first + 1))) {
+                add_segments(token_type::host_or_location, first, first);
+                ++first;
+            }
+            add_segments(token_type::location, first, year_segment - 2);
+            add_segments(token_type::isolation, year_segment - 1, year_segment - 1);
+            break;
+    }
+
+    const auto year_first = segments[year_segment].first;
+    const auto year_last = year_first + leading_digits(segment(year_segment));
+    add(token_type::year, year_first, year_last);
+    auto extra_first = year_last;
+    while (extra_first < segments[year_segment].last && std::isspace(source[extra_first]))
+        ++extra_first;
+    if (extra_first < segments[year_segment].last)
+        add(token_type::extra, extra_first, segments[year_segment].last);
+    if (year_segment + 1 < num_segments)
+        add_segments(token_type::extra, year_segment + 1, num_segments - 1);
+
+    return tokens;
+
+} // acmacs::virus::name::tokenize
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "acmacs-base/fmt.hh"
+
+// ----------------------------------------------------------------------
+
+namespace acmacs::virus::inline v2::name
+{
+    enum class token_type : uint8_t {
+        subtype,
+        host,
+        host_or_location,   // host not in the host list or first part of location, decided by locationdb lookups
+        location,
+        location_isolation, // location followed by isolation in the same segment, split by a location prefix lookup
+        isolation,
+        year,
+        extra
+    };
+
+    struct token_t
+    {
+        token_type type;
+        uint32_t offset; // in source passed to tokenize()
+        uint32_t length;
+
+        std::string_view text(std::string_view source) const { return source.substr(offset, length); }
+    };
+
+    using tokens_t = std::vector<token_t>;
+
+    // Single left to right pass over the name splitting it into slash
+    // separated segments (slashes inside parentheses do not separate),
+    // segments are then typed by their position from both ends:
+    //   [subtype /] [host /] location [/ location ...] [/ isolation] / year[extra] [/ extra ...]
+    // Segment is host if it is a known host and there are at least
+    // location, isolation and year after it. Location spanning several
+    // segments (A/Lyon/CHU/R19.03.77/2019) is one token including slashes.
+    // No locationdb lookups are made, where they are needed to type a
+    // segment, it gets a type naming both possibilities:
+    //  - host_or_location: segment without digits followed by another one
+    //    and isolation, it is either a host not in the host list
+    //    (A/wigeon/Italy/6127-23/2007) or the first part of location
+    //    (A/Lyon/CHU/R19.03.77/2019)
+    //  - location_isolation: segment at location position that starts
+    //    with a non-digit and has digits (A/chicken/Iran221/2001,
+    //    A/BiliranTB5/0423/2015, B/Cameroon11V-12080 GVFI/2011)
+    // Reassortant in front of the name (IVR-153 (A/CALIFORNIA/07/2009)) is
+    // not recognized.
+    tokens_t tokenize(std::string_view source);
+
+} // namespace acmacs::virus::inline v2::name
+
+// ----------------------------------------------------------------------
+
+template <> struct fmt::formatter<acmacs::virus::name::token_type> : public fmt::formatter<acmacs::fmt_helper::default_formatter>
+{
+    template <typename FormatContext> auto format(acmacs::virus::name::token_type type, FormatContext& ctx)
+    {
+        using namespace acmacs::virus::name;
+        switch (type) {
+            case token_type::subtype: return fmt::format_to(ctx.out(), "subtype");
+            case token_type::host: return fmt::format_to(ctx.out(), "host");
+            case token_type::host_or_location: return fmt::format_to(ctx.out(), "host_or_location");
+            case token_type::location: return fmt::format_to(ctx.out(), "location");
+            case token_type::location_isolation: return fmt::format_to(ctx.out(), "location_isolation");
+            case token_type::isolation: return fmt::format_to(ctx.out(), "isolation");
+            case token_type::year: return fmt::format_to(ctx.out(), "year");
+            case token_type::extra: return fmt::format_to(ctx.out(), "extra");
+        }
+        return ctx.out();
+    }
+};
+
+// ----------------------------------------------------------------------
+/// Local Variables:
+/// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))
+/// End:
@@ -1,7 +1,9 @@
 #include <iostream>
 #include <cctype>
+#include <algorithm>
 #include <array>
 #include <tuple>
+#include <optional>
 #include <regex>
 
 #include "acmacs-base/fmt.hh"
@@ -36,52 +38,210 @@ namespace virus_name
 
     namespace _internal
     {
-#pragma GCC diagnostic push
-#ifdef __clang__
-#pragma GCC diagnostic ignored "-Wglobal-constructors"
-#pragma GCC diagnostic ignored "-Wexit-time-destructors"
-#endif
-
-        const std::regex cdc_name{"^([A-Z][A-Z][A-Z]?)[ \\-]"}; // cdc names had location abbreviation separated with '-' earlier
-
-        // const std::string flu_a_subtype{"H[1-9][0-9]?(?:N[1-9][0-9]?)?"};
-        // const std::string flu_type_subtype("(?:B|A\\s*[\\(/]?" + flu_a_subtype + "\\)?)");
-        // const std::string flu_host{"[A-Z\\s]+"};
-        // const std::string flu_location{"[A-Z\\-_\\s0-9]+"};
-        // const std::string flu_isolation{"[^/]+"};
-        // const std::string flu_year{""};
-
-        constexpr const char* re_international_name =
-                "^(?:([AB][^/]*)/)?" // type subtype
-                "(?:([^/]+)/)?"      // host
-                "([^/]{2,})/"        // location/
-                "0*([^/]+)/"         // isolation /
-                "(19|20)?(\\d\\d)"   // year
-                "(?:\\s*\\)\\s*)?"   // closing ) surrounded with spaces
-                ;
-
-        constexpr const char* re_reassortant_passage = "(?:(?:\\s+|__)(.+))?";
-
-          // [1] - type+subtype, [2] - host, [3] - location, [4] - isolation-number (omitting leading zeros), [5] - century, [6] - year (2 last digit), [7] - reassortant and passage
-          // const std::regex international{"^([AB][^/]*)/(?:([^/]+)/)?([^/]+)/0*([^/]+)/(19|20)?(\\d\\d)(?:(?:\\s+|__)(.+))?$"};
-        const std::regex international{std::string(re_international_name) + re_reassortant_passage + '$'};
-        const std::regex international_name{re_international_name};
-        const std::regex international_name_with_extra{std::string(re_international_name) + "(?:[\\s_\\-]*(.+))?"};
-
-        const std::regex passage_after_name{" (MDCK|SIAT|MK|E|X)[X\\?\\d]"}; // to extract cdc name only! NOT to extract passage!
-
-#pragma GCC diagnostic pop
-
-        inline std::string make_year(const std::cmatch& m)
+        // Names are split by a hand written matcher instead of std::regex. It
+        // reproduces the backtracking order of the regexes used before:
+        //
+        //   international_name: "^(?:([AB][^/]*)/)?(?:([^/]+)/)?([^/]{2,})/0*([^/]+)/(19|20)?(\d\d)(?:\s*\)\s*)?"
+        //   international:      international_name + "(?:(?:\s+|__)(.+))?$"
+        //   international_name_with_extra: international_name + "(?:[\s_\-]*(.+))?"
+        //   passage_after_name: " (MDCK|SIAT|MK|E|X)[X\?\d]" (to extract cdc name only! NOT to extract passage!)
+        //   cdc_name:           "^([A-Z][A-Z][A-Z]?)[ \-]" (cdc names had location abbreviation separated with '-' earlier)
+        //
+        // test-virus-name-v1 compares results with the regex implementation.
+
+        inline bool is_space(char cc) { return cc == ' ' || (cc >= '\t' && cc <= '\r'); } // \s
+        inline bool is_digit(char cc) { return cc >= '0' && cc <= '9'; }
+        inline bool is_upper(char cc) { return cc >= 'A' && cc <= 'Z'; }
+        inline bool is_line_terminator(char cc) { return cc == '\n' || cc == '\r'; } // not matched by .
+
+        // views into the source
+        struct international_name_t
         {
-            std::string year;
-            if (m[5].length())
-                year = m[5].str() + m[6].str();
-            else if (m[6].str()[0] > '2')
-                year = "19" + m[6].str();
+            std::string_view virus_type{}, host{}, location{}, isolation{}; // isolation without leading zeros
+            std::string_view century{}, year{};                              // century is empty if year has two digits
+            size_t end{0};                                                   // end of the name (or start of the passage for split())
+        };
+
+        inline size_t skip_spaces(std::string_view source, size_t pos)
+        {
+            while (pos < source.size() && is_space(source[pos]))
+                ++pos;
+            return pos;
+        }
+
+        // (?:\s*\)\s*)?
+        inline size_t skip_closing_parenthesis(std::string_view source, size_t pos)
+        {
+            if (const auto paren = skip_spaces(source, pos); paren < source.size() && source[paren] == ')')
+                return skip_spaces(source, paren + 1);
+            return pos;
+        }
+
+        // Tries "[type-subtype/][host/]location/isolation/year" at the beginning
+        // of source in the order the regex does (optional parts present first,
+        // 4 digit year first), for each candidate calls tail(end-of-year), the
+        // first candidate accepted by tail is the result.
+        template <typename Tail> std::optional<international_name_t> match_international_name(std::string_view source, Tail&& tail)
+        {
+            std::array<size_t, 4> slash;
+            size_t slashes = 0;
+            for (size_t pos = 0; pos < source.size() && slashes < slash.size(); ++pos) {
+                if (source[pos] == '/')
+                    slash[slashes++] = pos;
+            }
+            const auto segment = [&](size_t no) {
+                const size_t start = no == 0 ? 0 : slash[no - 1] + 1;
+                return source.substr(start, slash[no] - start);
+            };
+            const auto digits = [source](size_t pos, size_t count) {
+                return pos + count <= source.size() && std::all_of(source.begin() + static_cast<std::ptrdiff_t>(pos), source.begin() + static_cast<std::ptrdiff_t>(pos + count), is_digit);
+            };
+
+            international_name_t fields;
+            const auto match_from = [&](size_t location_no) {
+                if (slashes < (location_no + 2))
+                    return false;
+                fields.location = segment(location_no);
+                fields.isolation = segment(location_no + 1);
+                if (fields.location.size() < 2 || fields.isolation.empty())
+                    return false;
+                fields.isolation.remove_prefix(std::min(fields.isolation.find_first_not_of('0'), fields.isolation.size() - 1)); // 0*([^/]+) keeps at least one symbol
+                const auto year_start = slash[location_no + 1] + 1;
+                if (digits(year_start, 4) && (source.substr(year_start, 2) == "19" || source.substr(year_start, 2) == "20")) {
+                    fields.century = source.substr(year_start, 2);
+                    fields.year = source.substr(year_start + 2, 2);
+                    if (tail(fields, year_start + 4))
+                        return true;
+                }
+                if (digits(year_start, 2)) {
+                    fields.century = std::string_view{};
+                    fields.year = source.substr(year_start, 2);
+                    if (tail(fields, year_start + 2))
+                        return true;
+                }
+                return false;
+            };
+
+            if (slashes > 0 && (source[0] == 'A' || source[0] == 'B')) {
+                fields.virus_type = segment(0);
+                if (slashes > 1 && !segment(1).empty()) {
+                    fields.host = segment(1);
+                    if (match_from(2))
+                        return fields;
+                }
+                fields.host = std::string_view{};
+                if (match_from(1))
+                    return fields;
+                fields.virus_type = std::string_view{};
+            }
+            if (slashes > 0 && !segment(0).empty()) {
+                fields.host = segment(0);
+                if (match_from(1))
+                    return fields;
+                fields.host = std::string_view{};
+            }
+            if (match_from(0))
+                return fields;
+            return std::nullopt;
+        }
+
+        // international_name, regex_search
+        inline std::optional<international_name_t> international_name(std::string_view source)
+        {
+            return match_international_name(source, [source](international_name_t& fields, size_t end_of_year) {
+                fields.end = skip_closing_parenthesis(source, end_of_year);
+                return true;
+            });
+        }
+
+        // international, regex_match: passage is source.substr(fields.end)
+        inline std::optional<international_name_t> international(std::string_view source)
+        {
+            // .+ up to the end of source
+            const auto any_to_end = [source](size_t pos) { return pos < source.size() && std::none_of(source.begin() + static_cast<std::ptrdiff_t>(pos), source.end(), is_line_terminator); };
+            // (?:(?:\s+|__)(.+))?$
+            const auto passage = [source, any_to_end](size_t pos) -> std::optional<size_t> {
+                for (auto start = skip_spaces(source, pos); start > pos; --start) {
+                    if (any_to_end(start))
+                        return start;
+                }
+                if (source.substr(pos, 2) == "__" && any_to_end(pos + 2))
+                    return pos + 2;
+                if (pos == source.size())
+                    return pos;
+                return std::nullopt;
+            };
+
+            return match_international_name(source, [source, &passage](international_name_t& fields, size_t end_of_year) {
+                if (const auto paren = skip_spaces(source, end_of_year); paren < source.size() && source[paren] == ')') {
+                    for (auto after = skip_spaces(source, paren + 1); after > paren; --after) {
+                        if (const auto start = passage(after); start.has_value()) {
+                            fields.end = *start;
+                            return true;
+                        }
+                    }
+                }
+                if (const auto start = passage(end_of_year); start.has_value()) {
+                    fields.end = *start;
+                    return true;
+                }
+                return false;
+            });
+        }
+
+        // (?:[\s_\-]*(.+))? after international_name
+        inline std::string_view extra_after_name(std::string_view source, size_t pos)
+        {
+            auto start = pos;
+            while (start < source.size() && (is_space(source[start]) || source[start] == '_' || source[start] == '-'))
+                ++start;
+            for (; start >= pos; --start) {
+                if (start < source.size() && !is_line_terminator(source[start])) {
+                    const auto end = std::find_if(source.begin() + static_cast<std::ptrdiff_t>(start), source.end(), is_line_terminator);
+                    return source.substr(start, static_cast<size_t>(end - source.begin()) - start);
+                }
+                if (start == pos)
+                    break;
+            }
+            return {};
+        }
+
+        // passage_after_name, returns position of the space before passage or std::string_view::npos
+        inline size_t passage_after_name(std::string_view source)
+        {
+            for (auto space = source.find(' '); space != std::string_view::npos; space = source.find(' ', space + 1)) {
+                const auto rest = source.substr(space + 1);
+                for (const std::string_view passage : {"MDCK", "SIAT", "MK", "E", "X"}) {
+                    if (rest.size() > passage.size() && rest.substr(0, passage.size()) == passage && (rest[passage.size()] == 'X' || rest[passage.size()] == '?' || is_digit(rest[passage.size()])))
+                        return space;
+                }
+            }
+            return std::string_view::npos;
+        }
+
+        // cdc_name, returns abbreviation or empty string
+        inline std::string_view cdc_name(std::string_view source)
+        {
+            const auto separator = [](char cc) { return cc == ' ' || cc == '-'; };
+            if (source.size() > 2 && is_upper(source[0]) && is_upper(source[1])) {
+                if (is_upper(source[2])) {
+                    if (source.size() > 3 && separator(source[3]))
+                        return source.substr(0, 3);
+                }
+                else if (separator(source[2]))
+                    return source.substr(0, 2);
+            }
+            return {};
+        }
+
+        inline std::string make_year(const international_name_t& fields)
+        {
+            if (!fields.century.empty())
+                return acmacs::string::concat(fields.century, fields.year);
+            else if (fields.year[0] > '2')
+                return acmacs::string::concat("19", fields.year);
             else
-                year = "20" + m[6].str();
-            return year;
+                return acmacs::string::concat("20", fields.year);
         }
 
         // constexpr const size_t international_name_suffix_size = 9; // len(lo/isolation-number/year) >= 9
@@ -97,12 +257,11 @@ namespace virus_name
 
     std::string_view name(std::string_view aFullName)
     {
-        std::cmatch m;
-        if (std::regex_search(aFullName.begin(), aFullName.end(), m, _internal::international_name)) {
-            return aFullName.substr(0, static_cast<size_t>(m.length()));
+        if (const auto fields = _internal::international_name(aFullName); fields.has_value()) {
+            return aFullName.substr(0, fields->end);
         }
-        else if (std::regex_search(aFullName.begin(), aFullName.end(), m, _internal::passage_after_name)) { // works for cdc name without extra and without reassortant (cdc names usually do not have reassortant)
-            return aFullName.substr(0, static_cast<size_t>(m.position()));
+        else if (const auto passage_start = _internal::passage_after_name(aFullName); passage_start != std::string_view::npos) { // works for cdc name without extra and without reassortant (cdc names usually do not have reassortant)
+            return aFullName.substr(0, passage_start);
         }
         else {
             return aFullName;   // failed to split, perhaps cdc name without passage
@@ -113,9 +272,8 @@ namespace virus_name
 
     std::string location_for_cdc_name(std::string_view name)
     {
-        std::cmatch m;
-        if (std::regex_search(std::begin(name), std::end(name), m, _internal::cdc_name))
-            return "#" + m[1].str();
+        if (const auto abbreviation = _internal::cdc_name(name); !abbreviation.empty())
+            return acmacs::string::concat('#', abbreviation);
         throw Unrecognized{fmt::format("No cdc abbreviation in {}", name)};
     }
 
@@ -130,9 +288,8 @@ namespace virus_name
         catch (Unrecognized&) {
         }
 
-        std::cmatch m;
-        if (std::regex_search(std::begin(name), std::end(name), m, _internal::international_name)) // international name with possible "garbage" after year, e.g. A/TOKYO/UT-IMS2-1/2014_HY-PR8-HA-N121K
-            return m[3].str();
+        if (const auto fields = _internal::international_name(name); fields.has_value()) // international name with possible "garbage" after year, e.g. A/TOKYO/UT-IMS2-1/2014_HY-PR8-HA-N121K
+            return std::string{fields->location};
 
         try {
             if (check_cdc_first == prioritize_cdc_name::no)
@@ -188,9 +345,8 @@ namespace virus_name
 
     std::string_view virus_type(std::string_view name) // pass by reference! because we return string_view to it
     {
-        std::cmatch m;
-        if (std::regex_search(std::begin(name), std::end(name), m, _internal::international_name))
-            return {name.data() + m.position(1), static_cast<size_t>(m.length(1))};
+        if (const auto fields = _internal::international_name(name); fields.has_value())
+            return fields->virus_type;
         throw Unrecognized(fmt::format("No virus_type in {}", name));
 
     }
@@ -199,14 +355,13 @@ namespace virus_name
 
     void split(std::string_view name, std::string& virus_type, std::string& host, std::string& location, std::string& isolation, std::string& year, std::string& passage)
     {
-        std::cmatch m;
-        if (std::regex_match(std::begin(name), std::end(name), m, _internal::international)) {
-            virus_type = m[1].str();
-            host = m[2].str();
-            location = m[3].str();
-            isolation = m[4].str();
-            year = _internal::make_year(m);
-            passage = m[7].str();
+        if (const auto fields = _internal::international(name); fields.has_value()) {
+            virus_type = fields->virus_type;
+            host = fields->host;
+            location = fields->location;
+            isolation = fields->isolation;
+            year = _internal::make_year(*fields);
+            passage = name.substr(fields->end);
         }
         else
             throw Unrecognized(fmt::format("Cannot split {}", name));
@@ -214,14 +369,13 @@ namespace virus_name
 
     void split_and_strip(std::string_view name, std::string& virus_type, std::string& host, std::string& location, std::string& isolation, std::string& year, std::string& extra)
     {
-        std::cmatch m;
-        if (std::regex_search(std::begin(name), std::end(name), m, _internal::international_name_with_extra)) {
-            virus_type = acmacs::string::strip(m[1].str());
-            host = acmacs::string::strip(m[2].str());
-            location = acmacs::string::strip(m[3].str());
-            isolation = acmacs::string::strip(m[4].str());
-            year = _internal::make_year(m);
-            extra = acmacs::string::join(acmacs::string::join_space, acmacs::string::strip(m.prefix().str()), acmacs::string::strip(m[7].str()));
+        if (const auto fields = _internal::international_name(name); fields.has_value()) {
+            virus_type = acmacs::string::strip(fields->virus_type);
+            host = acmacs::string::strip(fields->host);
+            location = acmacs::string::strip(fields->location);
+            isolation = acmacs::string::strip(fields->isolation);
+            year = _internal::make_year(*fields);
+            extra = acmacs::string::strip(_internal::extra_after_name(name, fields->end)); // name is matched from the beginning, nothing precedes it
         }
         else
             throw Unrecognized(fmt::format("Cannot split {}", name));
@@ -234,14 +388,13 @@ namespace virus_name
             split(name, virus_type, host, location, isolation, year, passage);
         }
         catch (Unrecognized&) {
-            std::cmatch m;
-            if (std::regex_search(std::begin(name), std::end(name), m, _internal::international_name_with_extra)) {
-                virus_type = m[1].str();
-                host = m[2].str();
-                location = m[3].str();
-                isolation = m[4].str();
-                year = _internal::make_year(m);
-                extra = acmacs::string::join(acmacs::string::join_space, m.prefix().str(), m[7].str());
+            if (const auto fields = _internal::international_name(name); fields.has_value()) {
+                virus_type = fields->virus_type;
+                host = fields->host;
+                location = fields->location;
+                isolation = fields->isolation;
+                year = _internal::make_year(*fields);
+                extra = _internal::extra_after_name(name, fields->end); // name is matched from the beginning, nothing precedes it
             }
             else
                 throw Unrecognized(fmt::format("Cannot split {}", name));
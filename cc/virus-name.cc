@@ -4,6 +4,7 @@
 #include "acmacs-base/string-split.hh"
 #include "acmacs-virus/log.hh"
 #include "acmacs-virus/virus-name-normalize.hh"
+#include "acmacs-virus/init.hh"
 
 // ----------------------------------------------------------------------
 
@@ -16,6 +17,9 @@ struct Options : public argv
     option<bool> print_messages{*this, 'm', desc{"print messages (when reading from file)"}};
     option<bool> print_hosts{*this, "hosts", desc{"print all hosts found (when reading from file)"}};
     option<bool> print_bad{*this, 'b', "bad", desc{"print names which were not parsed (when reading from file)"}};
+    option<bool> print_not_found_locations{*this, "not-found-locations", desc{"print locations not found in locationdb, most frequent first, with example names (when reading from file)"}};
+    option<bool> init{*this, "init", desc{"compile regexes and load locationdb in advance, report time and memory used"}};
+    option<bool> init_sequential{*this, "init-sequential", desc{"--init without using multiple threads"}};
     option<str_array> verbose{*this, 'v', "verbose", desc{"comma separated list (or multiple switches) of log enablers"}};
 
     argument<str_array> names{*this, arg_name{"name"}};
@@ -31,6 +35,8 @@ int main(int argc, const char* const* argv)
     try {
         Options opt(argc, argv);
         acmacs::log::enable(opt.verbose);
+        if (opt.init || opt.init_sequential)
+            AD_INFO("{}", acmacs::virus::init(opt.init_sequential ? acmacs::virus::init_parallel::no : acmacs::virus::init_parallel::yes));
         if (opt.from_file) {
             names_from_file(opt);
         }
@@ -58,27 +64,38 @@ void names_from_file(const Options& opt)
 {
     acmacs::Counter<acmacs::virus::host_t> hosts;
 
-    const std::string lines = acmacs::file::read(opt.from_file);
+    const std::string data = acmacs::file::read(opt.from_file);
+    const auto lines = acmacs::string::split(data, "\n", acmacs::string::Split::RemoveEmpty);
     size_t lines_read{0}, succeeded{0}, failed{0};
-    acmacs::messages::messages_t messages;
-    for (const auto& line : acmacs::string::split(lines, "\n", acmacs::string::Split::RemoveEmpty)) {
-        ++lines_read;
-        auto fields = acmacs::virus::name::parse(line);
-        if (!fields.messages.empty()) {
-            ++failed;
-            if (opt.print_bad)
-                fmt::print("{}\n", line);
-            acmacs::messages::move_and_add_source(messages, std::move(fields.messages), acmacs::messages::position_t{opt.from_file, lines_read});
+    acmacs::virus::name::message_aggregator_t messages;
+    acmacs::virus::name::not_found_locations_t not_found_locations;
+    constexpr const size_t batch_size{10000};
+    for (auto batch_first = lines.begin(); batch_first != lines.end();) {
+        const auto batch_last = std::next(batch_first, std::min(batch_size, static_cast<size_t>(std::distance(batch_first, lines.end()))));
+        const std::vector<std::string_view> batch(batch_first, batch_last);
+        const auto parsed = acmacs::virus::name::parse_batch(batch, acmacs::virus::name::parse_fields::all, acmacs::virus::name::message_policy::full, &not_found_locations);
+        for (size_t no = 0; no < batch.size(); ++no) {
+            ++lines_read;
+            const auto& fields = parsed[no];
+            if (!fields.messages.empty()) {
+                ++failed;
+                if (opt.print_bad)
+                    fmt::print("{}\n", batch[no]);
+                messages.add(fields.messages, acmacs::messages::position_t{opt.from_file, lines_read});
+            }
+            else
+                ++succeeded;
+            if (!fields.host.empty())
+                hosts.count(acmacs::virus::host_t{*fields.host});
+            // fmt::print("{} -> {}\n", batch[no], fields);
         }
-        else
-            ++succeeded;
-        if (!fields.host.empty())
-            hosts.count(fields.host);
-        // fmt::print("{} -> {}\n", line, fields);
+        batch_first = batch_last;
     }
     fmt::print("Lines: {:6d}\nGood:  {:6d}\nBad:   {:6d}\n", lines_read, succeeded, failed);
     if (opt.print_messages)
-        acmacs::virus::name::report(messages);
+        messages.report();
+    if (opt.print_not_found_locations)
+        not_found_locations.report();
     if (opt.print_hosts)
         fmt::print("\nHosts ({})\n{}\n", hosts.size(), hosts.report_sorted_max_first("    {first:40s} {second}\n"));
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <array>
+#include <span>
 #include <optional>
 
 #include "acmacs-base/log.hh"
@@ -33,6 +35,44 @@ namespace acmacs::virus::inline v2
 
     // ----------------------------------------------------------------------
 
+    // Slash positions of the name found in one pass, field accessors
+    // (same as host(), location(), isolation() and without_subtype() above)
+    // are then slices of the name, nothing is allocated. The name must
+    // outlive the object.
+    class name_fields_t
+    {
+      public:
+        explicit name_fields_t(std::string_view name) noexcept;
+        explicit name_fields_t(const name_t& name) noexcept : name_fields_t(std::string_view{*name}) {}
+
+        std::string_view host(std::string_view if_not_found = {}) const noexcept { return slashes_ == 4 ? field(first_[0] + 1, first_[1]) : if_not_found; }
+        std::string_view location(std::string_view if_not_found = {}) const noexcept { return slashes_ >= 2 ? field(slashes_ == 2 ? 0 : last_[0] + 1, last_[1]) : if_not_found; }
+        std::string_view isolation(std::string_view if_not_found = {}) const noexcept { return slashes_ >= 2 ? field(last_[1] + 1, last_[2]) : if_not_found; }
+        std::string_view without_subtype() const noexcept;
+
+      private:
+        std::string_view name_;
+        size_t slashes_{0};
+        std::array<size_t, 2> first_{0, 0}; // offsets of the first two slashes
+        std::array<size_t, 3> last_{0, 0, 0}; // offsets of the last three slashes, the last one in last_[2]
+
+        std::string_view field(size_t start, size_t end) const noexcept { return name_.substr(start, end - start); }
+    };
+
+    // name fields in columns, one row per name, views refer to the names
+    struct name_columns_t
+    {
+        std::vector<std::string_view> host{};
+        std::vector<std::string_view> location{};
+        std::vector<std::string_view> isolation{};
+        std::vector<std::optional<size_t>> year{};
+    };
+
+    // fills columns for names, previous content of columns is replaced (capacities are reused)
+    void name_columns(std::span<const name_t> names, name_columns_t& columns, std::string_view if_not_found = {});
+
+    // ----------------------------------------------------------------------
+
     void set_type_subtype(name_t& name, const type_subtype_t& type_subtype) noexcept;
 
     // ----------------------------------------------------------------------
@@ -55,6 +95,18 @@ namespace acmacs::virus::inline v2
 
 } // namespace acmacs::virus::inline v2
 
+// ----------------------------------------------------------------------
+
+template <> struct std::hash<acmacs::virus::name_t>
+{
+    size_t operator()(const acmacs::virus::name_t& name) const noexcept { return std::hash<std::string_view>{}(*name); }
+};
+
+template <> struct std::hash<acmacs::virus::host_t>
+{
+    size_t operator()(const acmacs::virus::host_t& host) const noexcept { return std::hash<std::string_view>{}(*host); }
+};
+
 // ----------------------------------------------------------------------
 /// Local Variables:
 /// eval: (if (fboundp 'eu-rename-buffer) (eu-rename-buffer))